@@ -0,0 +1,112 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+using namespace std;
+
+// concurrent disjoint set union (lock-free)
+// find, unite and sameSet can be called from many threads at once:
+// - roots are linked by one CAS on leader_, the root with the lower
+//   priority goes under the other one (priorities are a fixed random-like
+//   permutation of the indices, so the trees stay shallow without sizes)
+// - find halves the path with CAS, a failed CAS only means that
+//   another thread has already moved the pointer up
+// - the max element of a set (example) is kept with an atomic max
+//   and is exact when no unite is running
+// build O(n)
+// query O(logn) expected, without recursion
+class concurrentDsu {
+
+  private:
+	vector<atomic<int>> leader_;	// leader of set
+	vector<atomic<int>> mx_;		// max element of set (example)
+
+	// priority of element used for linking
+	static uint32_t prior(int a) { return uint32_t(a) * 2654435761u; }
+
+  public:
+	concurrentDsu(int n): leader_(n), mx_(n) {
+		for(int i = 0; i < n; ++i) {
+			mx_[i].store(i+1, memory_order_relaxed);
+			leader_[i].store(i, memory_order_relaxed);
+		}
+	}
+
+	// finds the leader of set that contains the element a
+	// (the result may be outdated if unites are running)
+	int find(int a) {
+		while(true) {
+			int p = leader_[a].load(memory_order_acquire);
+			if(p == a) return a;
+			int gp = leader_[p].load(memory_order_acquire);
+			if(gp != p) leader_[a].compare_exchange_weak(p, gp, memory_order_release, memory_order_relaxed);
+			a = gp;
+		}
+	}
+
+	// merges sets which include elements u and v
+	// returns false if these vertices already belong
+	// to the same set, and true otherwise
+	bool unite(int u, int v) {
+		while(true) {
+			u = find(u);
+			v = find(v);
+			if(u == v) return false;
+			if(prior(u) > prior(v)) swap(u, v);
+			int expected = u;
+			if(leader_[u].compare_exchange_strong(expected, v)) {
+				updateMax(v, mx_[u].load());
+				return true;
+			}
+		}
+	}
+
+	// checks whether u and v belong to the same set
+	bool sameSet(int u, int v) {
+		while(true) {
+			u = find(u);
+			v = find(v);
+			if(u == v) return true;
+			// u is still a root, so the sets were different at that moment
+			if(leader_[u].load() == u) return false;
+		}
+	}
+
+	// returns the max element of set that contains the element a
+	int getMax(int a) { return mx_[find(a)].load(); }
+
+  private:
+	// raises the max of set of the root r to x; if r stops being a root
+	// meanwhile, its new root may have missed x, so it is raised too
+	void updateMax(int r, int x) {
+		while(true) {
+			int cur = mx_[r].load();
+			while(cur < x && !mx_[r].compare_exchange_weak(cur, x)) {}
+			if(leader_[r].load() == r) return;
+			r = find(r);
+		}
+	}
+};
+
+int main() {
+
+	int n = 1000000;
+	concurrentDsu d(n);
+
+	// 4 threads unite the even elements and the odd elements in chains
+	vector<thread> threads;
+	for(int t = 0; t < 4; ++t) {
+		threads.emplace_back([&d, n, t] {
+			for(int i = t; i + 2 < n; i += 4) {
+				d.unite(i, i + 2);
+				d.unite(i + 1, i + 3);
+			}
+		});
+	}
+	for(thread& th : threads) th.join();
+
+	cout << d.sameSet(0, n - 2) << ' ' << d.sameSet(1, n - 1) << ' ' << d.sameSet(0, 1) << '\n';	// 1 1 0
+	cout << d.getMax(0) << ' ' << d.getMax(1) << '\n';		// 999999 1000000
+}
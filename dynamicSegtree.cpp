@@ -0,0 +1,109 @@
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+using ll = long long;
+using ull = unsigned long long;
+
+// dynamic segtree
+// segment tree over a huge range of indices [1; n] (up to 2^64-1) filled with zeroes,
+// nodes are created on the first touch and taken from one arena,
+// so the memory is O(qlogn) for q updates instead of O(n).
+// delayed updates are never pushed: each node keeps the sum of its subsegment
+// and the value added to the whole subsegment, so get doesn't create nodes
+// build	O(1)
+// get		O(logn)
+// update	O(logn)
+template<typename T>
+class dynamicSegtree {
+
+	struct node {
+		T sum;			// sum of the subsegment
+		T add;			// value added to every element of the subsegment
+		uint32_t left;	// left child (0 if not created yet)
+		uint32_t right;	// right child (0 if not created yet)
+	};
+
+  private:
+	ull n_;
+	vector<node> arena_;	// arena_[0] - null node, arena_[1] - root
+
+  public:
+	// builds segment tree over the vector of size _n filled with zeroes
+	dynamicSegtree(ull n): n_(n), arena_(2, {T(), T(), 0, 0}) {}
+
+	// reserves memory for cnt nodes (~2logn nodes per update)
+	void reserve(ull cnt) { arena_.reserve(cnt); }
+
+	// returns the count of created nodes
+	ull nodes() { return arena_.size() - 2; }
+
+	// returns the pth element of the vector
+	T get(ull p) { return getInternal(1, 1, n_, p, p); }
+
+	// computes the sum of the elements of subvector [l; r]
+	T get(ull l, ull r) { return getInternal(1, 1, n_, l, r); }
+
+	// adds x to pth element of the vector
+	void update(ull p, T x) { updateInternal(1, 1, n_, p, p, x); }
+
+	// adds x to the elements of the subvector [l; r]
+	void update(ull l, ull r, T x) { updateInternal(1, 1, n_, l, r, x); }
+
+  private:
+	uint32_t newNode() {
+		arena_.push_back({T(), T(), 0, 0});
+		return arena_.size() - 1;
+	}
+
+	// length of the intersection of [l; r] and [ql; qr]
+	ull overlap(ull l, ull r, ull ql, ull qr) { return min(r, qr) - max(l, ql) + 1; }
+
+	T getInternal(uint32_t t, ull l, ull r, ull ql, ull qr) {
+		if(t == 0 || ql > r || qr < l) return T();
+		if(ql <= l && qr >= r) return arena_[t].sum;
+		ull m = l + (r-l)/2;
+		T res = arena_[t].add * T(overlap(l, r, ql, qr));
+		res += getInternal(arena_[t].left, l, m, ql, qr);
+		res += getInternal(arena_[t].right, m+1, r, ql, qr);
+		return res;
+	}
+
+	void updateInternal(uint32_t t, ull l, ull r, ull ql, ull qr, T x) {
+		arena_[t].sum += x * T(overlap(l, r, ql, qr));
+		if(ql <= l && qr >= r) {
+			arena_[t].add += x;
+			return;
+		}
+		ull m = l + (r-l)/2;
+		if(ql <= m) {
+			if(arena_[t].left == 0) {
+				uint32_t c = newNode();
+				arena_[t].left = c;
+			}
+			updateInternal(arena_[t].left, l, m, ql, qr, x);
+		}
+		if(qr > m) {
+			if(arena_[t].right == 0) {
+				uint32_t c = newNode();
+				arena_[t].right = c;
+			}
+			updateInternal(arena_[t].right, m+1, r, ql, qr, x);
+		}
+	}
+};
+
+int main() {
+
+	dynamicSegtree<ll> seg(1ULL << 40);		// [1; 2^40]
+
+	seg.update(1000000000000ULL, 5);		// a[10^12] += 5
+	seg.update(1, 1ULL << 40, 1);			// a[i] += 1 for all i
+	seg.update(10, 19, 2);					// a[10..19] += 2
+
+	cout << seg.get(1000000000000ULL) << '\n';		// 6
+	cout << seg.get(1, 100) << '\n';				// 120
+	cout << seg.get(1, 1ULL << 40) << '\n';			// 1099511627801 (2^40 + 5 + 20)
+	cout << seg.nodes() << '\n';					// 88 nodes instead of 2^42
+}
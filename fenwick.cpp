@@ -0,0 +1,123 @@
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using ll = long long;
+using ull = unsigned long long;
+
+// fenwick tree (binary indexed tree)
+// point update and range sum with n memory and without recursion
+// build	O(n)
+// get		O(logn)
+// update	O(logn) (point only)
+template<typename T>
+class fenwick {
+
+  private:
+	ull n_;
+	vector<T> data_;	// data_[i] - sum of (i - (i & -i); i]
+
+  public:
+	// builds fenwick tree over the empty vector of size _n
+	fenwick(ull n): n_(n), data_(n + 1, T()) {}
+
+	// builds fenwick tree over the given vector
+	fenwick(const vector<T>& a): fenwick(a.size()) {
+		for(ull i = 1; i <= n_; ++i) {
+			data_[i] += a[i - 1];
+			ull j = i + (i & -i);
+			if(j <= n_) data_[j] += data_[i];
+		}
+	}
+
+	// returns the pth element of the vector
+	T get(ull p) { return prefix(p) - prefix(p-1); }
+
+	// computes the sum of the elements of subvector [l; r]
+	T get(ull l, ull r) { return prefix(r) - prefix(l-1); }
+
+	// adds x to pth element of the vector
+	void update(ull p, T x) {
+		for(; p <= n_; p += p & -p) data_[p] += x;
+	}
+
+	// computes the sum of the elements of subvector [1; p]
+	T prefix(ull p) {
+		T res = T();
+		for(; p > 0; p -= p & -p) res += data_[p];
+		return res;
+	}
+};
+
+// fenwick tree with range updates
+// range add and range sum with two fenwick trees:
+// prefix(p) = b1.prefix(p) * p - b2.prefix(p)
+// build	O(n)
+// get		O(logn)
+// update	O(logn)
+template<typename T>
+class rangeFenwick {
+
+  private:
+	ull n_;
+	fenwick<T> b1_, b2_;
+
+  public:
+	// builds fenwick tree over the empty vector of size _n
+	rangeFenwick(ull n): n_(n), b1_(n), b2_(n) {}
+
+	// builds fenwick tree over the given vector
+	rangeFenwick(const vector<T>& a): n_(a.size()), b1_(a.size()), b2_(negate(a)) {}
+
+	// returns the pth element of the vector
+	T get(ull p) { return get(p, p); }
+
+	// computes the sum of the elements of subvector [l; r]
+	T get(ull l, ull r) { return prefix(r) - prefix(l-1); }
+
+	// adds x to pth element of the vector
+	void update(ull p, T x) { update(p, p, x); }
+
+	// adds x to the elements of the subvector [l; r]
+	void update(ull l, ull r, T x) {
+		b1_.update(l, x);
+		b2_.update(l, x * T(l-1));
+		if(r < n_) {
+			b1_.update(r+1, -x);
+			b2_.update(r+1, -x * T(r));
+		}
+	}
+
+	// computes the sum of the elements of subvector [1; p]
+	T prefix(ull p) { return b1_.prefix(p) * T(p) - b2_.prefix(p); }
+
+  private:
+	// the initial values are stored in b2 as -a[p]
+	static vector<T> negate(vector<T> a) {
+		for(T& x : a) x = -x;
+		return a;
+	}
+};
+
+int main() {
+
+	vector<int> arr = {1, 2, 3, 4, 5, 6, 7, 8};
+
+	fenwick<int> fw(arr);
+
+	cout << fw.get(1, 3) << '\n';		// 6
+	cout << fw.get(4, 8) << '\n';		// 30
+	fw.update(2, 5);					// {1, 7, 3, 4, 5, 6, 7, 8}
+	cout << fw.get(2) << '\n';			// 7
+	cout << fw.get(1, 8) << "\n\n";		// 41
+
+	rangeFenwick<ll> rfw(vector<ll>(arr.begin(), arr.end()));
+
+	cout << rfw.get(1, 3) << '\n';		// 6
+	rfw.update(1, 8, 1);				// {2, 3, 4, 5, 6, 7, 8, 9}
+	cout << rfw.get(1, 3) << '\n';		// 9
+	cout << rfw.get(4, 8) << '\n';		// 35
+	rfw.update(3, 4, -10);				// {2, 3, -6, -5, 6, 7, 8, 9}
+	cout << rfw.get(4) << '\n';			// -5
+	cout << rfw.get(1, 8) << '\n';		// 24
+}
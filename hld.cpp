@@ -0,0 +1,310 @@
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+using ll = long long;
+using ull = unsigned long long;
+
+struct wedge {
+	int v;
+	ll w;
+};
+
+using graph = vector< vector<int> >;
+using wgraph = vector< vector<wedge> >;
+
+// segtree from segtreeUltraTemplate (without threads), hld works with any
+// tree<policy> that has tree(vector<T>), get(l, r) and update(l, r, x),
+// so the segtree of segtreeUltraTemplate and its policies can be used as well
+// the behaviour is defined by the policy (see examples below):
+//   op(a, b)			- target function (has to be associative)
+//   id()				- identity element of op (its type T is the type of the value)
+//   apply(a, u, len)	- applies update u to value a of the subsegment of length len,
+//						  returns false if the value can't be recomputed at once
+//						  (then the update is passed to the children; see beats there)
+//   compose(u, v)		- update that equals to v followed by u
+//   updId()			- update that changes nothing (its type U is the type of the update)
+// build	O(n)
+// get		O(logn)
+// update	O(logn)
+template<typename policy>
+class segtree {
+
+	using T = decltype(policy::id());
+	using U = decltype(policy::updId());
+
+  private:
+	ull n_;
+	vector<T> data_;
+	vector<U> delay_;		// update that has to be pushed to the children
+	vector<char> hasDelay_;	// is there any update in delay_?
+
+  public:
+	// builds segment tree over the given vector
+	segtree(const vector<T>& a): n_(a.size()), data_(4 * n_, policy::id()),
+			delay_(4 * n_, policy::updId()), hasDelay_(4 * n_, false) {
+		build(1, 1, n_, a);
+	}
+
+	// computes the target function on subvector [ql; qr]
+	T get(ull l, ull r) { return getInternal(1, 1, n_, l, r); }
+
+	// applies update x to the elements of subvector [l; r]
+	void update(ull l, ull r, U x) { updateInternal(1, 1, n_, l, r, x); }
+
+  private:
+	void build(ull id, ull l, ull r, const vector<T>& a) {
+		if(l == r) {
+			data_[id] = a[l - 1];
+			return;
+		}
+		ull m = (l+r)/2;
+		build(id*2, l, m, a);
+		build(id*2+1, m+1, r, a);
+		data_[id] = policy::op(data_[id*2], data_[id*2+1]);
+	}
+
+	void applyNode(ull id, ull l, ull r, const U& x) {
+		if(!policy::apply(data_[id], x, r-l+1)) {
+			push(id, l, r);
+			ull m = (l+r)/2;
+			applyNode(id*2, l, m, x);
+			applyNode(id*2+1, m+1, r, x);
+			data_[id] = policy::op(data_[id*2], data_[id*2+1]);
+			return;
+		}
+		if(l == r) return;
+		delay_[id] = hasDelay_[id] ? policy::compose(x, delay_[id]) : x;
+		hasDelay_[id] = true;
+	}
+
+	void push(ull id, ull l, ull r) {
+		if(!hasDelay_[id]) return;
+		ull m = (l+r)/2;
+		applyNode(id*2, l, m, delay_[id]);
+		applyNode(id*2+1, m+1, r, delay_[id]);
+		delay_[id] = policy::updId();
+		hasDelay_[id] = false;
+	}
+
+	T getInternal(ull id, ull l, ull r, ull ql, ull qr) {
+		if(ql > r || qr < l) return policy::id();
+		if(ql <= l && qr >= r) return data_[id];
+		push(id, l, r);
+		ull m = (l+r)/2;
+		return policy::op(getInternal(id*2, l, m, ql, qr), getInternal(id*2+1, m+1, r, ql, qr));
+	}
+
+	void updateInternal(ull id, ull l, ull r, ull ql, ull qr, const U& x) {
+		if(ql > r || qr < l) return;
+		if(ql <= l && qr >= r) {
+			applyNode(id, l, r, x);
+			return;
+		}
+		push(id, l, r);
+		ull m = (l+r)/2;
+		updateInternal(id*2, l, m, ql, qr, x);
+		updateInternal(id*2+1, m+1, r, ql, qr, x);
+		data_[id] = policy::op(data_[id*2], data_[id*2+1]);
+	}
+};
+
+// heavy-light decomposition
+// every vertex continues the chain of its parent if its subtree is the largest
+// among the siblings (heavy child), so a path crosses O(logn) chains;
+// vertices are numbered in dfs order with the heavy child first, so every
+// chain and every subtree is a segment of positions in the segment tree
+// values are kept on vertices (graph) or on edges (wgraph, the value of
+// an edge is kept in its lower vertex); op has to be commutative,
+// since the direction of the path is not kept
+// build				O(n)
+// get, update			O(log^2n) (path)
+// getSubtree, updateSubtree	O(logn)
+template<typename policy, template<typename> class tree = segtree>
+class hld {
+
+	using T = decltype(policy::id());
+	using U = decltype(policy::updId());
+
+  private:
+	int n_;					// vertex count
+	bool onEdges_;			// are values kept on edges?
+	vector<int> par_;		// parent of vertex
+	vector<int> d_;			// depth of vertex
+	vector<int> sz_;		// size of subtree of vertex
+	vector<int> head_;		// first (highest) vertex of the chain of vertex
+	vector<int> pos_;		// position of vertex in the segment tree (from 1)
+	tree<policy> seg_;
+
+  public:
+	// values on vertices (vals[v] - value of vertex v)
+	hld(const graph& g, int root, const vector<T>& vals): n_(g.size()), onEdges_(false), seg_(layout(g, root, vals)) {}
+
+	// values on edges (weights of edges, id() for the root)
+	hld(const wgraph& g, int root): n_(g.size()), onEdges_(true), seg_(layout(g, root, vector<T>())) {}
+
+	// finds the lca of vertices u and v
+	int lca(int u, int v) {
+		for(; head_[u] != head_[v]; u = par_[head_[u]]) {
+			if(d_[head_[u]] < d_[head_[v]]) swap(u, v);
+		}
+		return d_[u] < d_[v] ? u : v;
+	}
+
+	// computes the target function on the path between u and v
+	T get(int u, int v) {
+		T res = policy::id();
+		forPath(u, v, [&](int l, int r) { res = policy::op(res, seg_.get(l, r)); });
+		return res;
+	}
+
+	// applies update x to the path between u and v
+	void update(int u, int v, U x) { forPath(u, v, [&](int l, int r) { seg_.update(l, r, x); }); }
+
+	// computes the target function on the subtree of v
+	T getSubtree(int v) {
+		int l = pos_[v] + onEdges_, r = pos_[v] + sz_[v] - 1;
+		return l <= r ? seg_.get(l, r) : policy::id();
+	}
+
+	// applies update x to the subtree of v
+	void updateSubtree(int v, U x) {
+		int l = pos_[v] + onEdges_, r = pos_[v] + sz_[v] - 1;
+		if(l <= r) seg_.update(l, r, x);
+	}
+
+  private:
+	static int to(int v) { return v; }
+	static int to(const wedge& e) { return e.v; }
+	static T weight(int) { return policy::id(); }
+	static T weight(const wedge& e) { return T(e.w); }
+
+	// calls f(l, r) for the segments of positions of the path between u and v
+	template<typename F>
+	void forPath(int u, int v, F f) {
+		for(; head_[u] != head_[v]; u = par_[head_[u]]) {
+			if(d_[head_[u]] < d_[head_[v]]) swap(u, v);
+			f(pos_[head_[u]], pos_[u]);
+		}
+		if(d_[u] > d_[v]) swap(u, v);
+		if(pos_[u] + onEdges_ <= pos_[v]) f(pos_[u] + onEdges_, pos_[v]);
+	}
+
+	// builds the decomposition with iterative dfs,
+	// returns the values in the order of positions
+	template<typename G>
+	vector<T> layout(const G& g, int root, const vector<T>& vals) {
+		par_.assign(n_, root);
+		d_.assign(n_, 0);
+		sz_.assign(n_, 1);
+		head_.assign(n_, root);
+		pos_.assign(n_, 0);
+		vector<T> val(n_, policy::id());
+		vector<int> order, st = {root};
+		while(!st.empty()) {
+			int u = st.back();
+			st.pop_back();
+			order.push_back(u);
+			if(!vals.empty()) val[u] = vals[u];
+			for(const auto& e : g[u]) {
+				int v = to(e);
+				if(v == par_[u] && u != root) continue;
+				par_[v] = u;
+				d_[v] = d_[u] + 1;
+				val[v] = weight(e);
+				st.push_back(v);
+			}
+		}
+		vector<int> heavy(n_, -1);
+		for(int i = n_-1; i > 0; --i) {
+			int v = order[i], p = par_[v];
+			sz_[p] += sz_[v];
+			if(heavy[p] == -1 || sz_[v] > sz_[heavy[p]]) heavy[p] = v;
+		}
+		// the heavy child is pushed last, so its subtree is numbered first
+		vector<T> res(n_);
+		st = {root};
+		for(int cur = 1; !st.empty(); ++cur) {
+			int u = st.back();
+			st.pop_back();
+			pos_[u] = cur;
+			res[cur - 1] = val[u];
+			for(const auto& e : g[u]) {
+				int v = to(e);
+				if((v == par_[u] && u != root) || v == heavy[u]) continue;
+				head_[v] = v;
+				st.push_back(v);
+			}
+			if(heavy[u] != -1) {
+				head_[heavy[u]] = head_[u];
+				st.push_back(heavy[u]);
+			}
+		}
+		return res;
+	}
+};
+
+template<typename T>
+struct sumAdd {
+	static T op(T a, T b) { return a + b; }
+	static T id() { return T(); }
+	static bool apply(T& a, T u, ull len) { a += u * T(len); return true; }
+	static T compose(T u, T v) { return u + v; }
+	static T updId() { return T(); }
+};
+
+template<typename T>
+struct maxAdd {
+	static T op(T a, T b) { return max(a, b); }
+	static T id() { return numeric_limits<T>::lowest(); }
+	static bool apply(T& a, T u, ull) { a += u; return true; }
+	static T compose(T u, T v) { return u + v; }
+	static T updId() { return T(); }
+};
+
+template<typename T>
+struct maxSet {
+	static T op(T a, T b) { return max(a, b); }
+	static T id() { return numeric_limits<T>::lowest(); }
+	static bool apply(T& a, T u, ull) { a = u; return true; }
+	static T compose(T u, T) { return u; }
+	static T updId() { return T(); }
+};
+
+int main() {
+
+	int n = 7;
+	wgraph g(n);
+
+	g[0].push_back({1, 1});
+	g[1].push_back({2, 1});
+	g[1].push_back({3, 8});
+	g[0].push_back({4, 2});
+	g[4].push_back({5, 3});
+	g[5].push_back({6, 5});
+
+	//        0
+	//    (1)/ \(2)
+	//      /   4
+	//     1     \(3)
+	// (1)/ \(8)  5
+	//   2   3     \(5)
+	//              6
+
+	hld<maxSet<ll>> mx(g, 0);
+	cout << mx.get(2, 6) << ' ' << mx.get(3, 5) << '\n';	// 5 8
+	mx.update(1, 3, 0);										// edge (1, 3) becomes 0
+	cout << mx.get(3, 5) << ' ' << mx.lca(3, 6) << '\n';	// 3 0
+
+	hld<sumAdd<ll>> sum(g, 0);
+	sum.update(2, 5, 10);									// +10 to the edges of the path 2-1-0-4-5
+	cout << sum.get(2, 6) << ' ' << sum.getSubtree(4) << '\n';	// 52 18
+
+	graph t(3);
+	t[0] = {1, 2};
+	hld<sumAdd<int>> vs(t, 0, {5, 6, 7});					// values on vertices
+	vs.updateSubtree(0, 1);									// {6, 7, 8}
+	cout << vs.get(1, 2) << '\n';							// 21
+}
@@ -2,7 +2,7 @@
 #include <vector>
 #include <chrono>
 #include <random>
-#include <functional>
+#include <limits>
 
 using namespace std;
 using uint = unsigned int;
@@ -12,85 +12,80 @@ using ull = unsigned long long;
 // implicit treap (implicit cartesian tree)
 // it represents a sequence of elements and implements such O(logn)-operations
 // as insert, erase, get, set, compute target function on any subsegment,
-// update any subsegment (set*/add), reverse any subsegment
-// *by default
-template<typename T, typename targetFunctor = plus<T>>
+// update any subsegment, reverse any subsegment
+// target function and updates are defined by the policy (as in segtreeUltraTemplate,
+// the policies of both can be shared):
+// op - target function (associative, commutative if reverse is used), id - its identity
+// (its type T is the type of elements), apply(a, u, len) - applies u to the value a
+// of len elements, returns false if the value can't be recomputed at once (then
+// the update is passed to the children), compose(u, v) - update "v, then u",
+// updId - identity update (its type U is the type of updates)
+// every node keeps one combined delayed update for its children
+// nodes are stored in the arena of the tree and refer to each other by 32-bit
+// indices, erased nodes are reused, the whole tree is freed at once
+template<typename policy>
 class implicitTreap {
 	
-	enum treapUpdMode {
-		SET,
-		ADD
-	};
-	
-	// treapGetMode?
+	using T = decltype(policy::id());
+	using U = decltype(policy::updId());
 	
 	struct node {
 		uint cnt;		// count of nodes in the subtree
 		int prior;		// priority of node (used to achieve balancity of tree)
-		bool rev;		// is subTree reversed?
-		bool upd;		// does val have to be updated?
-		T val;			// value of node
+		bool rev;		// do children have to be reversed?
+		bool upd;		// do children have to be updated?
+		T val;			// value of node (updates are already applied)
 		T subVal;		// value of target function on subtree (subsegment)
-		T updVal;		// value that will update current one
-		node* left;		// left child
-		node* right;	// right child
+		U updVal;		// delayed update of children
+		uint left;		// left child
+		uint right;		// right child
 		
 		node(T _val, int _prior): cnt(1), prior(_prior), rev(false), upd(false) {
-			left = right = nullptr;
+			left = right = 0;
 			subVal = val = _val;
-			updVal = T();
+			updVal = policy::updId();
 		}
 	};
 	
-	using pnode = node*;
+	using pnode = uint;	// index of node in pool_, 0 - null
 	
   private:
 	pnode root_;
 	mt19937 rng_;
-	targetFunctor targetF_;
-	treapUpdMode updMode_;
+	vector<node> pool_;		// arena of nodes (pool_[0] - null node)
+	vector<pnode> free_;	// erased nodes that can be reused
+	vector<pnode> path_;	// nodes visited by the last split/merge
 	
   public:
 	implicitTreap() {
-		root_ = nullptr;
+		root_ = 0;
 		rng_ = mt19937(chrono::steady_clock::now().time_since_epoch().count());
-		targetF_ = targetFunctor();
-		updMode_ = SET;
+		pool_.emplace_back(policy::id(), 0);
+		pool_[0].cnt = 0;
 	}
 	
-	implicitTreap(uint n): implicitTreap() {
-		for(uint i = 0; i < n; ++i) {
-			pnode tn = new node(T(), rng_());
-			root_ = merge(root_, tn);
-		}
-	}
+	// builds the sequence of n elements T() ( in O(n) )
+	implicitTreap(uint n): implicitTreap(vector<T>(n, T())) {}
 	
-	implicitTreap(vector<T> arr): implicitTreap() {
-		for(uint i = 0; i < arr.size(); ++i) {
-			pnode tn = new node(arr[i], rng_());
-			root_ = merge(root_, tn);
-		}
+	// builds the given sequence ( in O(n) )
+	implicitTreap(const vector<T>& arr): implicitTreap() {
+		reserve(arr.size());
+		root_ = build(arr);
 	}
 	
-	// prints the sequence
-	void print() { printInternal(root_); cout << '\n'; } 
-	
-	// switches update mode to ADD ( in O(n) )
-	void switchUpdateModeToAdd() {
-		pushAll(root_);
-		updMode_ = ADD;
-	}
+	// reserves memory for n nodes
+	void reserve(uint n) { pool_.reserve(n + 1); }
 	
-	// switches update mode to SET ( in O(n) )
-	void switchUpdateModeToSet() {
-		pushAll(root_);
-		updMode_ = SET;
+	// prints the sequence
+	void print() {
+		forEach([](const T& x) { cout << x << ' '; });
+		cout << '\n';
 	}
 	
 	// inserts a new element before the pth element
 	void insert(uint p, T x) {
-		pnode tLeft = nullptr, tRight = nullptr;
-		pnode tNew = new node(x, rng_());
+		pnode tLeft = 0, tRight = 0;
+		pnode tNew = newNode(x);
 		split(root_, p, tLeft, tRight);
 		root_ = merge(tLeft, merge(tNew, tRight));
 	}
@@ -98,17 +93,17 @@ class implicitTreap {
 	// erases the pth element
 	void erase(uint p) {
 		pnode tLeft, tRight, tMid;
-		tLeft = tRight = tMid = nullptr;
+		tLeft = tRight = tMid = 0;
 		split(root_, p+1, tLeft, tRight);
 		split(tLeft, p, tLeft, tMid);
-		delete tMid;
+		if(tMid != 0) free_.push_back(tMid);
 		root_ = merge(tLeft, tRight);
 	}
 	
 	// returns the pth element
 	T get(uint p) {
 		pnode tLeft, tRight, tMid;
-		tLeft = tRight = tMid = nullptr;
+		tLeft = tRight = tMid = 0;
 		split(root_, p+1, tLeft, tRight);
 		split(tLeft, p, tLeft, tMid);
 		T ans = getVal(tMid);
@@ -119,7 +114,7 @@ class implicitTreap {
 	// returns the value of target function on the subsegment [l;r]
 	T get(uint l, uint r) {
 		pnode tLeft, tRight, tMid;
-		tLeft = tRight = tMid = nullptr;
+		tLeft = tRight = tMid = 0;
 		split(root_, r+1, tLeft, tRight);
 		split(tLeft, l, tLeft, tMid);
 		T ans = getSubVal(tMid);
@@ -130,146 +125,308 @@ class implicitTreap {
 	// sets the value of pth element to x
 	void set(uint p, T x) {
 		pnode tLeft, tRight, tMid;
-		tLeft = tRight = tMid = nullptr;
+		tLeft = tRight = tMid = 0;
 		split(root_, p+1, tLeft, tRight);
 		split(tLeft, p, tLeft, tMid);
-		tMid->val = x;
+		pool_[tMid].val = x;
+		updateCnt(tMid);
 		root_ = merge(tLeft, merge(tMid, tRight));
 	}
 	
-	// updates the subsegment [l;r] with value x (by default adds x)
-	void update(uint l, uint r, T x) {
+	// applies the update x to the subsegment [l;r]
+	void update(uint l, uint r, U x) {
 		pnode tLeft, tRight, tMid;
-		tLeft = tRight = tMid = nullptr;
+		tLeft = tRight = tMid = 0;
 		split(root_, r+1, tLeft, tRight);
 		split(tLeft, l, tLeft, tMid);
-		tMid->upd = true;
-		tMid->updVal = x;
+		applyNode(tMid, x);
 		root_ = merge(tLeft, merge(tMid, tRight));
 	}
 	
 	// reverses the subsegment [l;r]
 	void reverse(uint l, uint r) {
 		pnode tLeft, tRight, tMid;
-		tLeft = tRight = tMid = nullptr;
+		tLeft = tRight = tMid = 0;
+		split(root_, r+1, tLeft, tRight);
+		split(tLeft, l, tLeft, tMid);
+		pool_[tMid].rev ^= true;
+		root_ = merge(tLeft, merge(tMid, tRight));
+	}
+	
+	// moves the subsegment [l;r] so that it starts at the position dest
+	// of the resulting sequence
+	void move(uint l, uint r, uint dest) {
+		pnode tLeft, tRight, tMid;
+		tLeft = tRight = tMid = 0;
 		split(root_, r+1, tLeft, tRight);
 		split(tLeft, l, tLeft, tMid);
-		tMid->rev ^= true;
+		root_ = merge(tLeft, tRight);
+		split(root_, dest, tLeft, tRight);
+		root_ = merge(tLeft, merge(tMid, tRight));
+	}
+	
+	// erases the subsegment [l;r] and returns it as a new treap ( in O(logn + k), k = r-l+1 ):
+	// every treap has its own arena, so the k elements are copied into the new one
+	implicitTreap cut(uint l, uint r) {
+		pnode tLeft, tRight, tMid;
+		tLeft = tRight = tMid = 0;
+		split(root_, r+1, tLeft, tRight);
+		split(tLeft, l, tLeft, tMid);
+		vector<T> vals;
+		vals.reserve(getCnt(tMid));
+		auto collect = [&](const T& x) { vals.push_back(x); };
+		forEachInternal(tMid, collect);
+		freeTree(tMid);
+		root_ = merge(tLeft, tRight);
+		return implicitTreap(vals);
+	}
+	
+	// inserts the sequence of the other treap before the pth element ( in O(logn + k),
+	// k - its size ): every treap has its own arena, so its k nodes are copied
+	// into this one (with their delayed updates, which are pushed later as usual)
+	void paste(uint p, implicitTreap&& other) {
+		pnode tLeft, tRight;
+		tLeft = tRight = 0;
+		pnode tMid = absorb(other);
+		split(root_, p, tLeft, tRight);
 		root_ = merge(tLeft, merge(tMid, tRight));
 	}
 	
-	// TODO
-	// move segment?
+	// calls f for every element in order ( in O(n) )
+	template<typename F>
+	void forEach(F f) { forEachInternal(root_, f); }
+	
+	// returns the sequence ( in O(n) )
+	vector<T> toVector() {
+		vector<T> res;
+		res.reserve(getCnt(root_));
+		forEach([&](const T& x) { res.push_back(x); });
+		return res;
+	}
 	
   private:
-	uint getCnt(pnode t) { return t == nullptr ? 0 : t->cnt; }
-	T getVal(pnode t) { return t == nullptr ? T() : t->val; }
-	T getSubVal(pnode t) { return t == nullptr ? T() : t->subVal; }
-	T updateVal(T a, T b) { return updMode_ == ADD ? (a + b) : b; }
-	
-	T getRangedTargetF(T val, uint cnt) {
-		if(val == targetF_(val, val)) return val;
-		if(2*val == targetF_(val, val)) return val * cnt;
-		cout << "RANGED GET ERROR\n";
-		return T();
+	pnode newNode(T x) {
+		if(free_.empty()) {
+			pool_.emplace_back(x, rng_());
+			return pool_.size() - 1;
+		}
+		pnode t = free_.back();
+		free_.pop_back();
+		pool_[t] = node(x, rng_());
+		return t;
 	}
 	
-	void updateCnt(pnode t) {
-		if(t == nullptr) return;
-		t->cnt = 1 + getCnt(t->left) + getCnt(t->right);
-		if(t->upd) {
-			t->subVal = updateVal(t->subVal, getRangedTargetF(t->updVal, t->cnt));
-			t->upd = false;
-			t->updVal = T();
-			return;
+	// builds the treap over the sequence in O(n):
+	// the stack keeps the right spine, a new node becomes the right child of the
+	// last spine node with greater priority, the popped part becomes its left child;
+	// a popped subtree never changes again, so its cnt and subVal are computed on pop
+	pnode build(const vector<T>& arr) {
+		vector<pnode> st;
+		for(uint i = 0; i < arr.size(); ++i) {
+			pnode t = newNode(arr[i]);
+			pnode popped = 0;
+			while(!st.empty() && pool_[st.back()].prior < pool_[t].prior) {
+				popped = st.back();
+				st.pop_back();
+				updateCnt(popped);
+			}
+			pool_[t].left = popped;
+			if(!st.empty()) pool_[st.back()].right = t;
+			st.push_back(t);
 		}
-		t->subVal = t->val;
-		t->subVal = targetF_(t->subVal, getSubVal(t->left));
-		t->subVal = targetF_(t->subVal, getSubVal(t->right));
+		for(uint i = st.size(); i-- > 0; ) updateCnt(st[i]);
+		return st.empty() ? 0 : st[0];
 	}
 	
-	void push(pnode t) {
-		if(t == nullptr) return;
-		push(t, t->left);
-		push(t, t->right);
-		if(t->rev) swap(t->left, t->right);
-		if(t->upd) t->val = updateVal(t->val, t->updVal);
-		t->rev = false;
+	uint getCnt(pnode t) { return pool_[t].cnt; }
+	T getVal(pnode t) { return pool_[t].val; }
+	T getSubVal(pnode t) { return pool_[t].subVal; }
+	
+	void updateCnt(pnode t) {
+		if(t == 0) return;
+		pool_[t].cnt = 1 + getCnt(pool_[t].left) + getCnt(pool_[t].right);
+		pool_[t].subVal = policy::op(policy::op(getSubVal(pool_[t].left), pool_[t].val), getSubVal(pool_[t].right));
 	}
 	
-	void push(pnode t, pnode child) {
-		if(t == nullptr || child == nullptr) return;
-		child->rev ^= t->rev;
-		if(t->upd) {
-			child->upd = t->upd;
-			child->updVal = t->updVal;
+	// applies u to the whole subtree t: to its values now and to its children later
+	// (or to its children now, if subVal can't be recomputed at once)
+	void applyNode(pnode t, const U& u) {
+		if(t == 0) return;
+		policy::apply(pool_[t].val, u, 1);
+		if(!policy::apply(pool_[t].subVal, u, pool_[t].cnt)) {
+			push(t);
+			applyNode(pool_[t].left, u);
+			applyNode(pool_[t].right, u);
+			updateCnt(t);
+			return;
 		}
+		pool_[t].updVal = pool_[t].upd ? policy::compose(u, pool_[t].updVal) : u;
+		pool_[t].upd = true;
 	}
 	
-	void pushAll(pnode t) {
-		if(t == nullptr) return;
-		push(t);
-		pushAll(t->left);
-		pushAll(t->right);
-		updateCnt(t);
+	void push(pnode t) {
+		if(t == 0) return;
+		if(pool_[t].rev) {
+			swap(pool_[t].left, pool_[t].right);
+			if(pool_[t].left != 0) pool_[pool_[t].left].rev ^= true;
+			if(pool_[t].right != 0) pool_[pool_[t].right].rev ^= true;
+			pool_[t].rev = false;
+		}
+		if(pool_[t].upd) {
+			applyNode(pool_[t].left, pool_[t].updVal);
+			applyNode(pool_[t].right, pool_[t].updVal);
+			pool_[t].upd = false;
+			pool_[t].updVal = policy::updId();
+		}
 	}
 	
+	// splits t into t1 (first x0 elements) and t2 (the rest) top-down:
+	// nodes are pushed on the way down, l and r point to the links where
+	// the next parts of t1 and t2 are attached, then cnt and subVal of the
+	// visited nodes are recomputed from the bottom
 	void split(pnode t, uint x0, pnode& t1, pnode& t2) {
-		if(t == nullptr) {
-			t2 = t1 = nullptr;
-			return;
-		}
-		push(t);
-		if(x0 >= 1 + getCnt(t->left)) {
-			split(t->right, x0 - (1 + getCnt(t->left)), t->right, t2);
-			t1 = t;
-		} else {
-			split(t->left, x0, t1, t->left);
-			t2 = t;
+		pnode* l = &t1;
+		pnode* r = &t2;
+		path_.clear();
+		while(t != 0) {
+			push(t);
+			path_.push_back(t);
+			if(x0 >= 1 + getCnt(pool_[t].left)) {
+				x0 -= 1 + getCnt(pool_[t].left);
+				*l = t;
+				l = &pool_[t].right;
+				t = pool_[t].right;
+			} else {
+				*r = t;
+				r = &pool_[t].left;
+				t = pool_[t].left;
+			}
 		}
-		updateCnt(t);
+		*l = *r = 0;
+		for(uint i = path_.size(); i-- > 0; ) updateCnt(path_[i]);
 	}
 	
+	// merges t1 and t2 top-down in the same way:
+	// h points to the link where the next node of the result is attached
 	pnode merge(pnode t1, pnode t2) {
-		if(t1 == nullptr) return t2;
-		if(t2 == nullptr) return t1;
-		if(t1->prior > t2->prior) {
-			push(t1);
-			t1->right = merge(t1->right, t2);
-			updateCnt(t1);
-			return t1;
-		} else {
-			push(t2);
-			t2->left = merge(t1, t2->left);
-			updateCnt(t2);
-			return t2;
+		pnode res = 0;
+		pnode* h = &res;
+		path_.clear();
+		while(t1 != 0 && t2 != 0) {
+			if(pool_[t1].prior > pool_[t2].prior) {
+				push(t1);
+				path_.push_back(t1);
+				*h = t1;
+				h = &pool_[t1].right;
+				t1 = pool_[t1].right;
+			} else {
+				push(t2);
+				path_.push_back(t2);
+				*h = t2;
+				h = &pool_[t2].left;
+				t2 = pool_[t2].left;
+			}
 		}
+		*h = (t1 != 0 ? t1 : t2);
+		for(uint i = path_.size(); i-- > 0; ) updateCnt(path_[i]);
+		return res;
 	}
 	
-	void printInternal(pnode t) {
-		if(t == nullptr) return;
+	// in-order traversal, delayed updates are pushed on the way
+	template<typename F>
+	void forEachInternal(pnode t, F& f) {
+		if(t == 0) return;
 		push(t);
-		printInternal(t->left);
-		cout << t->val  << ' ';
-		printInternal(t->right);
-		updateCnt(t);
+		forEachInternal(pool_[t].left, f);
+		f(pool_[t].val);
+		forEachInternal(pool_[t].right, f);
+	}
+	
+	void freeTree(pnode t) {
+		vector<pnode> st;
+		if(t != 0) st.push_back(t);
+		while(!st.empty()) {
+			t = st.back();
+			st.pop_back();
+			free_.push_back(t);
+			if(pool_[t].left != 0) st.push_back(pool_[t].left);
+			if(pool_[t].right != 0) st.push_back(pool_[t].right);
+		}
+	}
+	
+	// moves the nodes of the other treap to the arena, returns the new root
+	pnode absorb(implicitTreap& other) {
+		vector<pnode> order, st;
+		if(other.root_ != 0) st.push_back(other.root_);
+		while(!st.empty()) {
+			pnode t = st.back();
+			st.pop_back();
+			order.push_back(t);
+			if(other.pool_[t].left != 0) st.push_back(other.pool_[t].left);
+			if(other.pool_[t].right != 0) st.push_back(other.pool_[t].right);
+		}
+		vector<pnode> newId(other.pool_.size(), 0);
+		for(uint i = 0; i < order.size(); ++i) newId[order[i]] = pool_.size() + i;
+		for(pnode t : order) {
+			node nd = other.pool_[t];
+			nd.left = newId[nd.left];
+			nd.right = newId[nd.right];
+			pool_.push_back(nd);
+		}
+		pnode res = newId[other.root_];
+		other.pool_.erase(other.pool_.begin() + 1, other.pool_.end());
+		other.free_.clear();
+		other.root_ = 0;
+		return res;
 	}
 };
 
-template<typename T, typename targetFunctor = plus<T>>
-using iTreap = implicitTreap<T, targetFunctor>;
+template<typename policy>
+using iTreap = implicitTreap<policy>;
+
+template<typename T>
+struct sumAdd {
+	static T op(T a, T b) { return a + b; }
+	static T id() { return T(); }
+	static bool apply(T& a, T u, ull len) { a += u * T(len); return true; }
+	static T compose(T u, T v) { return u + v; }
+	static T updId() { return T(); }
+};
 
+// sum with assignment
 template<typename T>
-struct mx { operator()(T a, T b) { return max(a, b); } };
+struct sumSet {
+	static T op(T a, T b) { return a + b; }
+	static T id() { return T(); }
+	static bool apply(T& a, T u, ull len) { a = u * T(len); return true; }
+	static T compose(T u, T) { return u; }
+	static T updId() { return T(); }
+};
+
+template<typename T>
+struct minAdd {
+	static T op(T a, T b) { return min(a, b); }
+	static T id() { return numeric_limits<T>::max(); }
+	static bool apply(T& a, T u, ull) { a += u; return true; }
+	static T compose(T u, T v) { return u + v; }
+	static T updId() { return T(); }
+};
+
+// sum with updates x -> a*x + b (u = {a, b}), so {1, b} adds b, {0, b} assigns b
+template<typename T>
+struct sumAffine {
+	static T op(T a, T b) { return a + b; }
+	static T id() { return T(); }
+	static bool apply(T& a, pair<T, T> u, ull len) { a = u.first * a + u.second * T(len); return true; }
+	static pair<T, T> compose(pair<T, T> u, pair<T, T> v) { return {u.first * v.first, u.first * v.second + u.second}; }
+	static pair<T, T> updId() { return {1, 0}; }
+};
 
 int main() {
 	
 	vector<int> arr = {1, 2, 3};
-	iTreap<int> t(arr);
-	// equals to
-	// iTreap<int, plus<int>> t(arr);
+	iTreap<sumAffine<int>> t(arr);
 	
-	t.switchUpdateModeToAdd();			// change update mode to add
 	t.print();							// {1, 2, 3}
 	t.insert(0, 5);						// insert 5 at pos 0
 	t.print();							// {5, 1, 2, 3}
@@ -277,7 +434,7 @@ int main() {
 	t.set(1, 7);						// set 2nd elem value to 7
 	t.print();							// {5, 7, 2, 3}
 	cout << t.get(1, 3) << '\n';		// get sum of {7, 2, 3} -> 12;
-	t.update(2, 3, 6);					// add 6 to 3rd and 4th elements
+	t.update(2, 3, {1, 6});				// add 6 to 3rd and 4th elements
 	t.print();							// {5, 7, 8, 9}
 	t.reverse(0, 2);					// reverse subsegment from 1st to 3rd element
 	t.reverse(1, 3);					// reverse subsegment from 2nd to 4th element
@@ -286,7 +443,22 @@ int main() {
 	cout << t.get(2) << '\n';			// get 3rd element -> 7
 	t.erase(0);							// erase 1st element -> 8
 	t.print();							// {9, 7}
-	t.switchUpdateModeToSet();			// change update mode to set
-	t.update(0, 1, 3);					// set all values to 3
+	t.update(0, 1, {0, 3});				// set all values to 3
 	t.print();							// {3, 3}
-}
\ No newline at end of file
+	t.update(0, 1, {2, 1});				// {7, 7}
+	t.update(1, 1, {1, 1});				// {7, 8}
+	cout << t.get(0, 1) << '\n';		// 15
+	
+	iTreap<sumAdd<int>> s({1, 2, 3, 4, 5, 6});
+	s.move(0, 1, 4);					// move {1, 2} to the end
+	s.print();							// {3, 4, 5, 6, 1, 2}
+	iTreap<sumAdd<int>> c = s.cut(1, 2);	// cut {4, 5}
+	s.paste(0, move(c));				// paste it at the beginning
+	for(int x : s.toVector()) cout << x << ' ';	// {4, 5, 3, 6, 1, 2}
+	cout << '\n';
+	
+	iTreap<minAdd<int>> m({5, 1, 4, 2});
+	m.update(0, 3, 10);					// {15, 11, 14, 12}
+	m.update(1, 2, -5);					// {15, 6, 9, 12}
+	cout << m.get(0, 3) << ' ' << m.get(2, 3) << '\n';	// 6 9
+}
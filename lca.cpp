@@ -1,12 +1,15 @@
 #include <iostream>
 #include <vector>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 using ll = long long;
+using ull = unsigned long long;
 using pll = pair<ll, ll>;
 
-const int MAX_D = 20;
-
 struct wedge {
 	int v;
 	ll w;
@@ -15,160 +18,391 @@ struct wedge {
 using graph = vector< vector<int> >;
 using wgraph = vector< vector<wedge> >;
 
+// calls f(i) for all i in [b; e) splitting the range between threads
+// (small ranges are processed by the calling thread)
+template<typename F>
+void parallelFor(ull b, ull e, ull threads, F f) {
+	const ull MIN_CHUNK = 1 << 16;
+	threads = max(1ULL, min(threads, (e - b) / MIN_CHUNK));
+	ull chunk = (e - b + threads - 1) / threads;
+	vector<thread> pool;
+	for(ull cb = b + chunk; cb < e; cb += chunk) {
+		pool.emplace_back([=] { for(ull i = cb; i < min(cb + chunk, e); ++i) f(i); });
+	}
+	for(ull i = b; i < min(b + chunk, e); ++i) f(i);
+	for(thread& t : pool) t.join();
+}
+
+// BINARY_LIFTING - ancestors 2^j levels up are stored for every vertex
+// EULER_TOUR - the lca is found by range minimum query over the dfs order
+enum lcaMode {BINARY_LIFTING, EULER_TOUR};
+
+// aggregates of edge data on a path (id - identity, its type is the type
+// of the data, op - associative operation)
+template<typename T>
+struct maxData {
+	static T id() { return numeric_limits<T>::lowest(); }
+	static T op(T a, T b) { return max(a, b); }
+};
+
+template<typename T>
+struct sumData {
+	static T id() { return T(); }
+	static T op(T a, T b) { return a + b; }
+};
+
 // lowest common ancestor (in tree ofc)
-// build O(n*MAX_D) <- O(nlogn)
-// query O(logn)
+// the tables are flat and level-major: up_[j*cap_ + v] - 2^j-th ancestor of v,
+// so every level is one contiguous array, and the count of levels LOG_ is
+// the least one with 2^LOG_ > max depth (it grows with the tree in addLeaf)
+// data_ keeps the aggregate (monoid) of edge data on the same 2^j edges
+// build O(nlogd)
+// query O(logd)
+// addLeaf O(logd) amortized
+template<lcaMode mode = BINARY_LIFTING, typename monoid = maxData<ll>>
 class lca {
 	
+	using T = decltype(monoid::id());
+	
   private:
 	int n_;						// vertex count
+	int cap_;					// count of vertices the levels have room for
+	int LOG_;					// count of levels
 	vector<int> d_;				// depth of vertices
-	vector< vector<int> > up_; 	// "binary" ancestors of a vertex
-								// up[v][0] - 1st ancestor of v,
-								// up[v][1] - 2nd ancestor of v,
-								// up[v][2] - 4th ancestor of v,
-								// up[v][3] - 8th ancestor of v...
-	vector< vector<ll> > data_;	// max data (example)
+	vector<int> up_;			// "binary" ancestors of a vertex
+								// up_[0*cap_ + v] - 1st ancestor of v,
+								// up_[1*cap_ + v] - 2nd ancestor of v,
+								// up_[2*cap_ + v] - 4th ancestor of v...
+	vector<T> data_;			// aggregate of data of the same edges
 	
   public:
-	// dfs to fill vector d and first ancestors in vector up
-	void dfs(const graph& g, int u, int prev) {
-		for(int v : g[u]) {
-			if(v == prev) continue;
-			d_[v] = d_[u] + 1;
-			up_[v][0] = u;
-			dfs(g, v, u);
+	lca(const graph& g, int root) { build(g, root); }
+	
+	lca(const wgraph& g, int root) { build(g, root); }
+	
+	// adds a leaf-node to the tree
+	// u - the parent of new node, w - data of the new edge
+	void addLeaf(int u, T w = monoid::id()) {
+		int depth = d_[u] + 1;
+		if(n_ == cap_ || (depth >> LOG_) > 0) relayout(n_ == cap_ ? 2 * cap_ : cap_, max(LOG_, bitWidth(depth)));
+		int v = n_++;
+		d_.push_back(depth);
+		up_[v] = u;
+		data_[v] = w;
+		for(int j = 1; j < LOG_; ++j) {
+			int mid = up_[(j-1)*cap_ + v];
+			up_[j*cap_ + v] = up_[(j-1)*cap_ + mid];
+			data_[j*cap_ + v] = monoid::op(data_[(j-1)*cap_ + v], data_[(j-1)*cap_ + mid]);
 		}
 	}
 	
-	void dfs(const wgraph& g, int u, int prev) {
-		for(wedge wdg : g[u]) {
-			int v = wdg.v;
-			int w = wdg.w;
-			if(v == prev) continue;
-			d_[v] = d_[u] + 1;
-			up_[v][0] = u;
-			data_[v][0] = w;
-			dfs(g, v, u);
-		}
+	// checks if vertex u is the parent of vertex v
+	bool isParent(int u, int v) {
+		if(d_[u] > d_[v]) return false;
+		return u == lift(v, d_[v] - d_[u]);
 	}
 	
-	lca(const graph& g, int root) {
-		n_ = g.size();
-		d_.assign(n_, 0);
-		up_.assign(n_, vector<int>(MAX_D, 0));
-		data_.assign(n_, vector<ll>(MAX_D, 0));
-		up_[root][0] = 0;
-		dfs(g, root, root);
-		for(int j = 1; j < MAX_D; ++j) {
-			for(int u = 0; u < n_; ++u) {
-				up_[u][j] = up_[up_[u][j-1]][j-1];
-				data_[u][j] = max(data_[u][j-1], data_[up_[u][j-1]][j-1]);
+	// finds the lca of vertices u and v
+	int find(int u, int v) {
+		if(d_[u] > d_[v]) swap(u,v);
+		v = lift(v, d_[v] - d_[u]);
+		if(u == v) return u;
+		for(int j = LOG_-1; j >= 0; --j) {
+			if(up_[j*cap_ + u] != up_[j*cap_ + v]) {
+				u = up_[j*cap_ + u];
+				v = up_[j*cap_ + v];
 			}
 		}
+		return up_[u];
 	}
 	
-	lca(const wgraph& g, int root) {
-		n_ = g.size();
-		d_.assign(n_, 0);
-		up_.assign(n_, vector<int>(MAX_D, 0));
-		data_.assign(n_, vector<ll>(MAX_D, 0));
-		up_[root][0] = 0;
-		dfs(g, root, root);
-		for(int j = 1; j < MAX_D; ++j) {
-			for(int u = 0; u < n_; ++u) {
-				up_[u][j] = up_[up_[u][j-1]][j-1];
-				data_[u][j] = max(data_[u][j-1], data_[up_[u][j-1]][j-1]);
+	// finds the lca of every pair, the answers are in the order of pairs
+	// threads = 1 - offline Tarjan's algorithm: one dfs over the tree with dsu,
+	//               O(n + q*α(n)) instead of q lifting walks
+	// threads > 1 - pairs are split between threads, each answers them by find
+	//               (the tables are only read)
+	vector<int> findBatch(const vector<pair<int, int>>& qs, int threads = 1) {
+		vector<int> res(qs.size());
+		if(threads > 1) {
+			parallelFor(0, qs.size(), threads, [&](ull i) { res[i] = find(qs[i].first, qs[i].second); });
+			return res;
+		}
+		// children and queries of every vertex as ranges of flat arrays
+		vector<int> childStart(n_ + 1, 0), child(n_), qStart(n_ + 1, 0);
+		vector<pair<int, int>> qList(2 * qs.size());	// (other vertex, index of pair)
+		int root = 0;
+		for(int v = 0; v < n_; ++v) {
+			if(d_[v] == 0) root = v;
+			else ++childStart[up_[v] + 1];
+		}
+		for(auto [u, v] : qs) {
+			++qStart[u + 1];
+			++qStart[v + 1];
+		}
+		for(int v = 0; v < n_; ++v) {
+			childStart[v + 1] += childStart[v];
+			qStart[v + 1] += qStart[v];
+		}
+		vector<int> cpos(childStart.begin(), childStart.end() - 1), qpos(qStart.begin(), qStart.end() - 1);
+		for(int v = 0; v < n_; ++v) {
+			if(d_[v] != 0) child[cpos[up_[v]]++] = v;
+		}
+		for(int i = 0; i < (int)qs.size(); ++i) {
+			qList[qpos[qs[i].first]++] = {qs[i].second, i};
+			qList[qpos[qs[i].second]++] = {qs[i].first, i};
+		}
+		// leader[v] - parent in dsu or -(size), anc[leader] - the current
+		// ancestor of the set (the finished subtrees are united with their parents)
+		vector<int> leader(n_, -1), anc(n_), next(childStart.begin(), childStart.end() - 1);
+		vector<char> done(n_, false);
+		auto findSet = [&](int a) {
+			while(leader[a] >= 0) {
+				if(leader[leader[a]] >= 0) leader[a] = leader[leader[a]];
+				a = leader[a];
 			}
+			return a;
+		};
+		vector<int> st = {root};
+		anc[root] = root;
+		while(!st.empty()) {
+			int u = st.back();
+			if(next[u] < childStart[u + 1]) {
+				int v = child[next[u]++];
+				anc[v] = v;
+				st.push_back(v);
+				continue;
+			}
+			st.pop_back();
+			done[u] = true;
+			for(int k = qStart[u]; k < qStart[u + 1]; ++k) {
+				auto [w, i] = qList[k];
+				if(done[w]) res[i] = anc[findSet(w)];
+			}
+			if(u == root) continue;
+			int lu = findSet(u), lp = findSet(up_[u]);
+			if(leader[lu] < leader[lp]) swap(lu, lp);
+			leader[lp] += leader[lu];
+			leader[lu] = lp;
+			anc[lp] = up_[u];
 		}
+		return res;
 	}
 	
-	// adds a leaf-node to the tree
-	// u - the parent of new node
-	void addLeaf(int u) {
-		d_.push_back(d_[u]+1);
-		up_.push_back(vector<int>(MAX_D));
-		up_[n_][0] = u;
-		for(int j = 1; j < MAX_D; ++j) {
-			up_[n_][j] = up_[up_[n_][j-1]][j-1];
-			data_[n_][j] = max(data_[n_][j-1], data_[up_[n_][j-1]][j-1]);
-		}
-		++n_;
-	}
+	// finds the distance between vertices u and v
+	int getLen(int u, int v) { return d_[u] + d_[v] - 2 * d_[find(u, v)]; }
 	
-	// checks if vertex u is the parent of vertex v
-	bool isParent(int u, int v) {
-		if(d_[u] > d_[v]) return false;
+	// finds the aggregate of data between vertices u and v (max by default)
+	T getData(int u, int v) {
+		if(d_[u] > d_[v]) swap(u,v);
 		int delta = d_[v] - d_[u];
-		for(int j = MAX_D-1; j >= 0; --j) {
+		T res = monoid::id();
+		for(int j = LOG_-1; j >= 0; --j) {
 			if(delta & (1 << j)) {
-				v = up_[v][j];
+				res = monoid::op(res, data_[j*cap_ + v]);
+				v = up_[j*cap_ + v];
+			}
+		}
+		if(u == v) return res;
+		for(int j = LOG_-1; j >= 0; --j) {
+			if(up_[j*cap_ + u] != up_[j*cap_ + v]) {
+				res = monoid::op(monoid::op(res, data_[j*cap_ + u]), data_[j*cap_ + v]);
+				u = up_[j*cap_ + u];
+				v = up_[j*cap_ + v];
 			}
 		}
-		return u == v;
+		return monoid::op(monoid::op(res, data_[u]), data_[v]);
 	}
 	
-	// finds the lca of vertices u and v
-	int find(int u, int v) {
-		if(d_[u] > d_[v]) swap(u,v);
-		int delta = d_[v] - d_[u];
-		for(int j = MAX_D-1; j >= 0; --j) {
-			if(delta & (1 << j)) {
-				v = up_[v][j];
+  private:
+	static int to(int v) { return v; }
+	static int to(const wedge& e) { return e.v; }
+	static T weight(int) { return monoid::id(); }
+	static T weight(const wedge& e) { return T(e.w); }
+	
+	// count of bits of x (the least LOG with 2^LOG > x), at least 1
+	static int bitWidth(int x) { return x == 0 ? 1 : 32 - __builtin_clz(x); }
+	
+	// returns the ancestor of v delta levels up
+	int lift(int v, int delta) {
+		for(int j = 0; delta > 0; ++j, delta >>= 1) {
+			if(delta & 1) v = up_[j*cap_ + v];
+		}
+		return v;
+	}
+	
+	// fills the first level with an iterative dfs, then the other levels
+	template<typename G>
+	void build(const G& g, int root) {
+		n_ = cap_ = g.size();
+		d_.assign(n_, 0);
+		up_.assign(n_, root);
+		data_.assign(n_, monoid::id());
+		vector<int> st = {root};
+		int maxD = 0;
+		while(!st.empty()) {
+			int u = st.back();
+			st.pop_back();
+			maxD = max(maxD, d_[u]);
+			for(const auto& e : g[u]) {
+				int v = to(e);
+				if(v == up_[u] && u != root) continue;
+				d_[v] = d_[u] + 1;
+				up_[v] = u;
+				data_[v] = weight(e);
+				st.push_back(v);
 			}
 		}
-		if(u == v) return u;
-		for(int j = MAX_D-1; j >= 0; --j) {
-			if(up_[u][j] != up_[v][j]) {
-				u = up_[u][j];
-				v = up_[v][j];
+		LOG_ = 1;
+		relayout(cap_, bitWidth(maxD));
+	}
+	
+	// moves the levels to the arrays with room for cap vertices
+	// and computes the missing levels up to LOG
+	void relayout(int cap, int LOG) {
+		vector<int> up(LOG * cap);
+		vector<T> data(LOG * cap);
+		for(int j = 0; j < LOG_; ++j) {
+			copy(up_.begin() + j*cap_, up_.begin() + j*cap_ + n_, up.begin() + j*cap);
+			copy(data_.begin() + j*cap_, data_.begin() + j*cap_ + n_, data.begin() + j*cap);
+		}
+		for(int j = LOG_; j < LOG; ++j) {
+			for(int v = 0; v < n_; ++v) {
+				int mid = up[(j-1)*cap + v];
+				up[j*cap + v] = up[(j-1)*cap + mid];
+				data[j*cap + v] = monoid::op(data[(j-1)*cap + v], data[(j-1)*cap + mid]);
 			}
 		}
-		return up_[u][0];
+		swap(up_, up);
+		swap(data_, data);
+		cap_ = cap;
+		LOG_ = LOG;
+	}
+};
+
+// lowest common ancestor with O(1) queries (static tree)
+// vertices are numbered in dfs order (tin), for u != v with tin[u] < tin[v]
+// lca is the parent with the least tin among the parents of the vertices
+// with tin in (tin[u]; tin[v]], so a query is one range minimum query
+// over the array val[i] = tin[parent of the ith vertex in dfs order]:
+// - blocks of 64 elements: a sparse table over the minimums of blocks,
+// - inside a block: mask[i] keeps the stack of suffix minimums of the block
+//   up to i, so the minimum of [l; i] is at the lowest bit of mask[i] >= l
+// memory is O(n), the dfs is iterative
+// build O(n)
+// query O(1)
+template<typename monoid>
+class lca<EULER_TOUR, monoid> {
+	
+  private:
+	int n_;						// vertex count
+	int nb_;					// count of blocks
+	vector<int> d_;				// depth of vertices
+	vector<int> tin_;			// position of vertex in dfs order
+	vector<int> sz_;			// size of subtree of vertex
+	vector<int> order_;			// vertices in dfs order
+	vector<int> val_;			// val_[i] - tin of the parent of order_[i]
+	vector<uint64_t> mask_;		// stacks of minimums inside blocks
+	vector<int> sparse_;		// sparse_[j*nb_ + b] - min of val_ over blocks [b; b + 2^j)
+	
+  public:
+	lca(const graph& g, int root) { build(g, root); }
+	
+	lca(const wgraph& g, int root) { build(g, root); }
+	
+	// checks if vertex u is the parent of vertex v
+	bool isParent(int u, int v) { return tin_[u] <= tin_[v] && tin_[v] < tin_[u] + sz_[u]; }
+	
+	// finds the lca of vertices u and v
+	int find(int u, int v) {
+		if(u == v) return u;
+		int l = tin_[u], r = tin_[v];
+		if(l > r) swap(l, r);
+		return order_[rmq(l+1, r)];
+	}
+	
+	// finds the lca of every pair, the answers are in the order of pairs
+	// (pairs are split between threads)
+	vector<int> findBatch(const vector<pair<int, int>>& qs, int threads = 1) {
+		vector<int> res(qs.size());
+		parallelFor(0, qs.size(), threads, [&](ull i) { res[i] = find(qs[i].first, qs[i].second); });
+		return res;
 	}
 	
 	// finds the distance between vertices u and v
-	int getLen(int u, int v) {
-		if(d_[u] > d_[v]) swap(u,v);
-		int delta = d_[v] - d_[u];
-		int res = delta;
-		for(int j = MAX_D-1; j >= 0; --j) {
-			if(delta & (1 << j)) {
-				v = up_[v][j];
+	int getLen(int u, int v) { return d_[u] + d_[v] - 2 * d_[find(u, v)]; }
+	
+  private:
+	static int to(int v) { return v; }
+	static int to(const wedge& e) { return e.v; }
+	
+	template<typename G>
+	void build(const G& g, int root) {
+		n_ = g.size();
+		d_.assign(n_, 0);
+		tin_.assign(n_, 0);
+		sz_.assign(n_, 1);
+		order_.assign(n_, 0);
+		val_.assign(n_, 0);
+		vector<int> par(n_, root);
+		vector<int> st = {root};
+		for(int t = 0; !st.empty(); ++t) {
+			int u = st.back();
+			st.pop_back();
+			tin_[u] = t;
+			order_[t] = u;
+			val_[t] = tin_[par[u]];
+			for(const auto& e : g[u]) {
+				int v = to(e);
+				if(v == par[u] && u != root) continue;
+				par[v] = u;
+				d_[v] = d_[u] + 1;
+				st.push_back(v);
 			}
 		}
-		if(u == v) return res;
-		for(int j = MAX_D-1; j >= 0; --j) {
-			if(up_[u][j] != up_[v][j]) {
-				u = up_[u][j];
-				v = up_[v][j];
-				res += 2 * (1 << j);
+		for(int t = n_-1; t > 0; --t) sz_[par[order_[t]]] += sz_[order_[t]];
+		
+		mask_.assign(n_, 0);
+		nb_ = (n_ + 63) / 64;
+		int levels = 1;
+		while((1 << levels) <= nb_) ++levels;
+		sparse_.assign(levels * nb_, 0);
+		for(int b = 0; b < nb_; ++b) {
+			uint64_t cur = 0;
+			int mn = val_[b*64];
+			for(int i = b*64; i < min(n_, b*64 + 64); ++i) {
+				while(cur != 0 && val_[b*64 + 63 - __builtin_clzll(cur)] >= val_[i]) {
+					cur ^= 1ULL << (63 - __builtin_clzll(cur));
+				}
+				cur |= 1ULL << (i - b*64);
+				mask_[i] = cur;
+				mn = min(mn, val_[i]);
+			}
+			sparse_[b] = mn;
+		}
+		for(int j = 1; j < levels; ++j) {
+			for(int b = 0; b + (1 << j) <= nb_; ++b) {
+				sparse_[j*nb_ + b] = min(sparse_[(j-1)*nb_ + b], sparse_[(j-1)*nb_ + b + (1 << (j-1))]);
 			}
 		}
-		return res + 2;
 	}
 	
-	// finds max data between vertices u and v (example)
-	int getMaxData(int u, int v) {
-        if(d_[u] > d_[v]) swap(u,v);
-        int delta = d_[v] - d_[u];
-        ll res = -2e9;
-        for(int j = MAX_D-1; j >= 0; --j) {
-            if(delta & (1 << j)) {
-                res = max(res, data_[v][j]);
-                v = up_[v][j];
-            }
-        }
-        if(u == v) return res;
-        for(int j = MAX_D-1; j >= 0; --j) {
-            if(up_[u][j] != up_[v][j]) {
-                res = max(max(res, data_[u][j]), data_[v][j]);
-                u = up_[u][j];
-                v = up_[v][j];
-            }
-        }
-        return max(max(res, data_[u][0]), data_[v][0]);
-    }
+	// min of val_ over [l; r] inside one block
+	int inBlock(int l, int r) {
+		uint64_t m = mask_[r] & (~0ULL << (l & 63));
+		return val_[(r & ~63) + __builtin_ctzll(m)];
+	}
+	
+	// min of val_ over [l; r]
+	int rmq(int l, int r) {
+		int bl = l >> 6, br = r >> 6;
+		if(bl == br) return inBlock(l, r);
+		int res = min(inBlock(l, bl*64 + 63), inBlock(br*64, r));
+		if(bl + 1 < br) {
+			int j = 31 - __builtin_clz(br - bl - 1);
+			res = min(res, min(sparse_[j*nb_ + bl+1], sparse_[j*nb_ + br - (1 << j)]));
+		}
+		return res;
+	}
 };
  
 int main() {
@@ -199,7 +433,22 @@ int main() {
 	
 	lca c(g, 0);
 	cout << c.getLen(2, 6) << '\n';		// 5
-	cout << c.getMaxData(2, 6) << '\n';	// 5
-	cout << c.getMaxData(2, 5) << '\n';	// 3
-	cout << c.getMaxData(3, 5) << '\n';	// 8
+	cout << c.getData(2, 6) << '\n';		// 5
+	cout << c.getData(2, 5) << '\n';		// 3
+	cout << c.getData(3, 5) << '\n';		// 8
+	c.addLeaf(6, 4);					// 7 - child of 6, edge data 4
+	cout << c.getLen(3, 7) << ' ' << c.getData(5, 7) << "\n\n";	// 6 5
+	
+	lca<BINARY_LIFTING, sumData<ll>> sum(g, 0);
+	cout << sum.getData(2, 6) << "\n\n";	// 12
+	
+	lca<EULER_TOUR> e(g, 0);
+	cout << e.find(2, 3) << ' ' << e.find(3, 6) << '\n';	// 1 0
+	cout << e.getLen(2, 6) << ' ' << e.isParent(4, 6) << "\n\n";	// 5 1
+	
+	vector<pair<int, int>> qs = {{2, 3}, {3, 6}, {5, 6}, {7, 7}};
+	for(int x : c.findBatch(qs)) cout << x << ' ';			// 1 0 5 7
+	cout << '\n';
+	for(int x : c.findBatch(qs, 4)) cout << x << ' ';		// 1 0 5 7
+	cout << '\n';
 }
\ No newline at end of file
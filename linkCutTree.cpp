@@ -0,0 +1,247 @@
+#include <iostream>
+#include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+using ll = long long;
+
+struct wedge {
+	int v;
+	ll w;
+};
+
+using graph = vector< vector<int> >;
+using wgraph = vector< vector<wedge> >;
+
+// link-cut tree
+// it represents a forest that changes: edges can be added (link) and
+// removed (cut), and the sum and the max of weights of edges on a path
+// are found; every path of the forest that was accessed last is kept
+// in a splay tree (ordered by depth), the splay trees are linked by
+// path-parent pointers; an edge is a node of its own (with its weight)
+// between the nodes of its vertices, so the aggregates are over edges
+// vertices - nodes 1..n, edges - nodes n+1.. (erased ones are reused),
+// all nodes are stored in one arena and refer to each other by indices
+// link, cut, connected, lca, getSum, getMax	O(logn) amortized
+class linkCutTree {
+
+	static constexpr ll NONE = numeric_limits<ll>::min();	// max of no edges
+
+	struct node {
+		int ch[2];		// children in splay tree
+		int p;			// parent in splay tree or path-parent
+		bool rev;		// do children have to be swapped?
+		ll w;			// weight (NONE for vertices)
+		ll sum;			// sum of weights in splay subtree
+		ll mx;			// max of weights in splay subtree
+	};
+
+  private:
+	int n_;						// vertex count
+	vector<node> t_;			// arena of nodes (t_[0] - null node)
+	vector<int> free_;			// erased edge nodes that can be reused
+	map<pair<int, int>, int> edges_;	// node of every edge (u < v)
+	vector<int> path_;			// nodes from x to the root of its splay tree (used by splay)
+
+  public:
+	// builds the forest of n vertices without edges
+	linkCutTree(int n): n_(n), t_(n + 1, node{{0, 0}, 0, false, NONE, 0, NONE}) {}
+
+	// builds the forest of the given graph (an edge given twice is linked once)
+	linkCutTree(const wgraph& g): linkCutTree(g.size()) {
+		for(int u = 0; u < n_; ++u) {
+			for(wedge e : g[u]) link(u, e.v, e.w);
+		}
+	}
+
+	// adds the edge (u, v) with weight w
+	// returns false if u and v are already connected (then nothing is changed)
+	bool link(int u, int v, ll w) {
+		if(connected(u, v)) return false;
+		int e = newNode(w);
+		edges_[key(u, v)] = e;
+		linkInternal(u+1, e);
+		linkInternal(e, v+1);
+		return true;
+	}
+
+	// removes the edge (u, v)
+	// returns false if there is no such edge
+	bool cut(int u, int v) {
+		auto it = edges_.find(key(u, v));
+		if(it == edges_.end()) return false;
+		int e = it->second;
+		edges_.erase(it);
+		cutInternal(u+1, e);
+		cutInternal(e, v+1);
+		free_.push_back(e);
+		return true;
+	}
+
+	// sets the weight of the edge (u, v) to w
+	void update(int u, int v, ll w) {
+		int e = edges_.at(key(u, v));
+		access(e);
+		splay(e);
+		t_[e].w = w;
+		pull(e);
+	}
+
+	// checks if u and v are in the same tree
+	bool connected(int u, int v) { return u == v || findRoot(u+1) == findRoot(v+1); }
+
+	// finds the lca of vertices u and v in the tree rooted at root
+	// (they have to be in the same tree)
+	int lca(int u, int v, int root) {
+		makeRoot(root+1);
+		access(u+1);
+		return access(v+1) - 1;
+	}
+
+	// finds the sum of weights of the path between u and v (they have to be connected)
+	ll getSum(int u, int v) { return pathNode(u, v).sum; }
+
+	// finds the max weight on the path between u and v (they have to be connected)
+	ll getMax(int u, int v) { return pathNode(u, v).mx; }
+
+  private:
+	static pair<int, int> key(int u, int v) { return {min(u, v), max(u, v)}; }
+
+	int newNode(ll w) {
+		int x;
+		if(free_.empty()) {
+			t_.push_back({});
+			x = t_.size() - 1;
+		} else {
+			x = free_.back();
+			free_.pop_back();
+		}
+		t_[x] = node{{0, 0}, 0, false, w, w, w};
+		return x;
+	}
+
+	bool isRoot(int x) { int p = t_[x].p; return p == 0 || (t_[p].ch[0] != x && t_[p].ch[1] != x); }
+
+	void pull(int x) {
+		node& a = t_[x];
+		a.sum = (a.w == NONE ? 0 : a.w) + t_[a.ch[0]].sum + t_[a.ch[1]].sum;
+		a.mx = max(a.w, max(t_[a.ch[0]].mx, t_[a.ch[1]].mx));
+	}
+
+	void push(int x) {
+		if(!t_[x].rev) return;
+		swap(t_[x].ch[0], t_[x].ch[1]);
+		for(int c : t_[x].ch) {
+			if(c != 0) t_[c].rev ^= true;
+		}
+		t_[x].rev = false;
+	}
+
+	void rotate(int x) {
+		int p = t_[x].p, g = t_[p].p;
+		int dir = t_[p].ch[1] == x;
+		if(!isRoot(p)) t_[g].ch[t_[g].ch[1] == p] = x;
+		t_[x].p = g;
+		t_[p].ch[dir] = t_[x].ch[dir ^ 1];
+		if(t_[x].ch[dir ^ 1] != 0) t_[t_[x].ch[dir ^ 1]].p = p;
+		t_[x].ch[dir ^ 1] = p;
+		t_[p].p = x;
+		pull(p);
+		pull(x);
+	}
+
+	// moves x to the root of its splay tree
+	// (delayed reverses are pushed from the root down to x first)
+	void splay(int x) {
+		path_.clear();
+		for(int y = x; ; y = t_[y].p) {
+			path_.push_back(y);
+			if(isRoot(y)) break;
+		}
+		for(int i = path_.size(); i-- > 0; ) push(path_[i]);
+		while(!isRoot(x)) {
+			int p = t_[x].p, g = t_[p].p;
+			if(!isRoot(p)) rotate((t_[g].ch[1] == p) == (t_[p].ch[1] == x) ? p : x);
+			rotate(x);
+		}
+	}
+
+	// makes the path from the root to x preferred (one splay tree),
+	// returns the last node where the path joined the previous preferred path
+	int access(int x) {
+		int last = 0;
+		for(int y = x; y != 0; y = t_[y].p) {
+			splay(y);
+			t_[y].ch[1] = last;
+			pull(y);
+			last = y;
+		}
+		splay(x);
+		return last;
+	}
+
+	void makeRoot(int x) {
+		access(x);
+		t_[x].rev ^= true;
+		push(x);
+	}
+
+	int findRoot(int x) {
+		access(x);
+		for(push(x); t_[x].ch[0] != 0; push(x)) x = t_[x].ch[0];
+		splay(x);
+		return x;
+	}
+
+	void linkInternal(int x, int y) {
+		makeRoot(x);
+		t_[x].p = y;
+	}
+
+	void cutInternal(int x, int y) {
+		makeRoot(x);
+		access(y);
+		t_[y].ch[0] = 0;
+		t_[x].p = 0;
+		pull(y);
+	}
+
+	// the node whose splay subtree is the path between u and v
+	const node& pathNode(int u, int v) {
+		makeRoot(u+1);
+		access(v+1);
+		return t_[v+1];
+	}
+};
+
+int main() {
+
+	int n = 7;
+	wgraph g(n);
+
+	g[0].push_back({1, 1});
+	g[1].push_back({2, 1});
+	g[1].push_back({3, 8});
+	g[0].push_back({4, 2});
+	g[4].push_back({5, 3});
+	g[5].push_back({6, 5});
+
+	//        0
+	//    (1)/ \(2)
+	//      /   4
+	//     1     \(3)
+	// (1)/ \(8)  5
+	//   2   3     \(5)
+	//              6
+
+	linkCutTree t(g);
+	cout << t.getSum(2, 6) << ' ' << t.getMax(2, 6) << '\n';	// 12 5
+	cout << t.lca(3, 6, 0) << ' ' << t.lca(3, 2, 4) << '\n';	// 0 1
+	t.cut(0, 4);
+	cout << t.connected(2, 6) << ' ' << t.link(3, 5, 4) << '\n';	// 0 1
+	cout << t.getSum(2, 6) << ' ' << t.getMax(0, 6) << '\n';		// 18 8
+	t.update(1, 3, 2);
+	cout << t.getMax(0, 6) << '\n';									// 5
+}
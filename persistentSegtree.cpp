@@ -0,0 +1,150 @@
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+using ll = long long;
+using ull = unsigned long long;
+
+// persistent segtree
+// every update creates a new version of the vector and keeps the old ones
+// available; versions share unchanged nodes (path copying), all nodes live
+// in one arena and refer to their children by 32-bit indices
+// build			O(n)
+// get				O(logn)
+// update			O(logn) (+ O(logn) new nodes)
+// collect			O(count of nodes in the alive versions)
+template<typename T>
+class persistentSegtree {
+
+	struct node {
+		T sum;			// sum of the subsegment
+		uint32_t left;	// left child
+		uint32_t right;	// right child
+	};
+
+  public:
+	using versionId = uint32_t;
+
+  private:
+	ull n_;
+	vector<node> arena_;		// arena_[0] is the empty node (sum 0, children - itself)
+	vector<uint32_t> root_;		// root of each version
+	vector<char> alive_;		// is the version still needed?
+
+  public:
+	// creates version 0 - the vector of size _n filled with zeroes
+	persistentSegtree(ull n): n_(n), arena_(1, {T(), 0, 0}), root_(1, 0), alive_(1, true) {}
+
+	// creates version 0 - the given vector
+	persistentSegtree(const vector<T>& a): persistentSegtree(a.size()) {
+		arena_.reserve(2 * n_);
+		root_[0] = build(1, n_, a);
+	}
+
+	// returns the count of created versions
+	versionId size() { return root_.size(); }
+
+	// returns the pth element of the vector in version v
+	T get(versionId v, ull p) { return getInternal(root_[v], 1, n_, p, p); }
+
+	// computes the sum of the elements of subvector [l; r] in version v
+	T get(versionId v, ull l, ull r) { return getInternal(root_[v], 1, n_, l, r); }
+
+	// adds x to pth element of the vector in version v
+	// returns the id of the new version
+	versionId update(versionId v, ull p, T x) {
+		root_.push_back(updateInternal(root_[v], 1, n_, p, x));
+		alive_.push_back(true);
+		return root_.size() - 1;
+	}
+
+	// marks version v as unneeded, its nodes will be freed by collect
+	void release(versionId v) { alive_[v] = false; }
+
+	// frees nodes that are unreachable from the alive versions
+	// ids of the alive versions stay valid
+	void collect() {
+		vector<char> used(arena_.size(), false);
+		vector<uint32_t> st;
+		used[0] = true;
+		for(versionId v = 0; v < root_.size(); ++v) {
+			if(alive_[v]) st.push_back(root_[v]);
+		}
+		while(!st.empty()) {
+			uint32_t t = st.back();
+			st.pop_back();
+			if(used[t]) continue;
+			used[t] = true;
+			st.push_back(arena_[t].left);
+			st.push_back(arena_[t].right);
+		}
+		// children are always created before their parents, so the nodes
+		// can be moved to the front in the order of their indices
+		vector<uint32_t> newId(arena_.size(), 0);
+		uint32_t cnt = 1;
+		for(uint32_t t = 1; t < arena_.size(); ++t) {
+			if(!used[t]) continue;
+			newId[t] = cnt;
+			arena_[cnt++] = {arena_[t].sum, newId[arena_[t].left], newId[arena_[t].right]};
+		}
+		arena_.resize(cnt);
+		arena_.shrink_to_fit();
+		for(versionId v = 0; v < root_.size(); ++v) {
+			root_[v] = alive_[v] ? newId[root_[v]] : 0;
+		}
+	}
+
+  private:
+	uint32_t newNode(T sum, uint32_t left, uint32_t right) {
+		arena_.push_back({sum, left, right});
+		return arena_.size() - 1;
+	}
+
+	uint32_t build(ull l, ull r, const vector<T>& a) {
+		if(l == r) return newNode(a[l - 1], 0, 0);
+		ull m = (l+r)/2;
+		uint32_t left = build(l, m, a);
+		uint32_t right = build(m+1, r, a);
+		return newNode(arena_[left].sum + arena_[right].sum, left, right);
+	}
+
+	T getInternal(uint32_t t, ull l, ull r, ull ql, ull qr) {
+		if(t == 0 || ql > r || qr < l) return T();
+		if(ql <= l && qr >= r) return arena_[t].sum;
+		ull m = (l+r)/2;
+		return getInternal(arena_[t].left, l, m, ql, qr) + getInternal(arena_[t].right, m+1, r, ql, qr);
+	}
+
+	uint32_t updateInternal(uint32_t t, ull l, ull r, ull p, T x) {
+		if(l == r) return newNode(arena_[t].sum + x, 0, 0);
+		ull m = (l+r)/2;
+		uint32_t left = arena_[t].left;
+		uint32_t right = arena_[t].right;
+		if(p <= m) left = updateInternal(left, l, m, p, x);
+		else right = updateInternal(right, m+1, r, p, x);
+		return newNode(arena_[left].sum + arena_[right].sum, left, right);
+	}
+};
+
+int main() {
+
+	vector<int> arr = {1, 2, 3, 4, 5, 6, 7, 8};
+	persistentSegtree<int> seg(arr);			// version 0
+
+	auto v1 = seg.update(0, 2, 10);				// {1, 12, 3, 4, 5, 6, 7, 8}
+	auto v2 = seg.update(v1, 8, -8);			// {1, 12, 3, 4, 5, 6, 7, 0}
+	auto v3 = seg.update(0, 5, 100);			// {1, 2, 3, 4, 105, 6, 7, 8}
+
+	cout << seg.get(0, 1, 8) << '\n';			// 36
+	cout << seg.get(v1, 1, 8) << '\n';			// 46
+	cout << seg.get(v2, 1, 8) << '\n';			// 38
+	cout << seg.get(v3, 4, 5) << "\n\n";		// 109
+
+	seg.release(0);
+	seg.release(v1);
+	seg.collect();								// only v2 and v3 remain
+
+	cout << seg.get(v2, 2) << '\n';				// 12
+	cout << seg.get(v3, 1, 8) << '\n';			// 136
+}
@@ -0,0 +1,173 @@
+#include <iostream>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+// disjoint set union with rollback
+// union by size without path compression, so every unite can be undone
+// build O(n)
+// query O(logn)
+// rollback O(1) per undone unite
+class rollbackDsu {
+
+  private:
+	vector<int> leader_;				// leader of set
+	vector<int> sz_;					// size of set
+	vector<pair<int, int>> history_;	// merged leaders (lu was attached to lv)
+	int comps_;							// count of sets
+
+  public:
+	rollbackDsu(int n): leader_(n), sz_(n, 1), comps_(n) {
+		for(int i = 0; i < n; ++i) leader_[i] = i;
+	}
+
+	// finds the leader of set that contains the element a
+	int find(int a) {
+		while(leader_[a] != a) a = leader_[a];
+		return a;
+	}
+
+	// merges sets which include elements u and v
+	// returns false if these vertices already belong
+	// to the same set, and true otherwise
+	bool unite(int u, int v) {
+		int lu = find(u);
+		int lv = find(v);
+		if(lu == lv) return false;
+		if(sz_[lu] > sz_[lv]) swap(lu, lv);
+		leader_[lu] = lv;
+		sz_[lv] += sz_[lu];
+		--comps_;
+		history_.push_back({lu, lv});
+		return true;
+	}
+
+	// returns the count of sets
+	int count() { return comps_; }
+
+	// returns the state that can be restored by rollback
+	int snapshot() { return history_.size(); }
+
+	// undoes all unites made after the snapshot
+	void rollback(int snap) {
+		while((int)history_.size() > snap) {
+			auto [lu, lv] = history_.back();
+			history_.pop_back();
+			leader_[lu] = lu;
+			sz_[lv] -= sz_[lu];
+			++comps_;
+		}
+	}
+};
+
+// offline dynamic connectivity
+// edges are added and removed over time, queries ask whether two vertices
+// are connected at the moment; every edge lives on a segment of queries,
+// the segment is put into O(logq) nodes of a segment tree over the queries,
+// dfs over the tree unites the edges of a node on the way down and
+// rolls them back on the way up
+// solve O((n + q + m) logq logn)
+class dynamicConnectivity {
+
+  private:
+	int n_;
+	vector<pair<int, int>> queries_;					// vertices of each query
+	map<pair<int, int>, vector<int>> open_;				// alive edge -> times when it was added
+	vector<pair<pair<int, int>, pair<int, int>>> edges_;	// edge and its segment of queries
+	vector<vector<pair<int, int>>> tree_;				// edges of each node of segment tree
+
+  public:
+	dynamicConnectivity(int n): n_(n) {}
+
+	// adds the edge (u, v) (multiple edges are allowed)
+	void addEdge(int u, int v) {
+		if(u > v) swap(u, v);
+		open_[{u, v}].push_back(queries_.size());
+	}
+
+	// removes one of the edges (u, v)
+	void removeEdge(int u, int v) {
+		if(u > v) swap(u, v);
+		auto it = open_.find({u, v});
+		if(it == open_.end()) return;
+		int from = it->second.back();
+		it->second.pop_back();
+		if(it->second.empty()) open_.erase(it);
+		if(from < (int)queries_.size()) edges_.push_back({{u, v}, {from, (int)queries_.size() - 1}});
+	}
+
+	// asks whether u and v are connected now, returns the id of the query
+	int query(int u, int v) {
+		queries_.push_back({u, v});
+		return queries_.size() - 1;
+	}
+
+	// returns the answers for all queries
+	vector<bool> solve() {
+		int q = queries_.size();
+		vector<bool> res(q);
+		if(q == 0) return res;
+		tree_.assign(4 * q, {});
+		for(auto& [e, times] : open_) {
+			for(int from : times) {
+				if(from < q) addInternal(1, 0, q - 1, from, q - 1, e);
+			}
+		}
+		for(auto& [e, seg] : edges_) addInternal(1, 0, q - 1, seg.first, seg.second, e);
+		rollbackDsu d(n_);
+		solveInternal(1, 0, q - 1, d, res);
+		tree_.clear();
+		return res;
+	}
+
+  private:
+	void addInternal(int id, int l, int r, int ql, int qr, pair<int, int> e) {
+		if(ql > r || qr < l) return;
+		if(ql <= l && qr >= r) {
+			tree_[id].push_back(e);
+			return;
+		}
+		int m = (l+r)/2;
+		addInternal(id*2, l, m, ql, qr, e);
+		addInternal(id*2+1, m+1, r, ql, qr, e);
+	}
+
+	void solveInternal(int id, int l, int r, rollbackDsu& d, vector<bool>& res) {
+		int snap = d.snapshot();
+		for(auto [u, v] : tree_[id]) d.unite(u, v);
+		if(l == r) {
+			res[l] = d.find(queries_[l].first) == d.find(queries_[l].second);
+		} else {
+			int m = (l+r)/2;
+			solveInternal(id*2, l, m, d, res);
+			solveInternal(id*2+1, m+1, r, d, res);
+		}
+		d.rollback(snap);
+	}
+};
+
+int main() {
+
+	rollbackDsu d(4);
+	d.unite(0, 1);
+	int snap = d.snapshot();
+	d.unite(2, 3);
+	d.unite(1, 2);
+	cout << d.count() << '\n';				// 1
+	d.rollback(snap);
+	cout << d.count() << ' ' << (d.find(0) == d.find(1)) << ' ' << (d.find(1) == d.find(2)) << "\n\n";	// 3 1 0
+
+	dynamicConnectivity dc(4);
+	dc.addEdge(0, 1);
+	dc.addEdge(1, 2);
+	dc.query(0, 2);							// 1
+	dc.removeEdge(1, 0);
+	dc.query(0, 2);							// 0
+	dc.addEdge(0, 3);
+	dc.addEdge(3, 2);
+	dc.query(0, 2);							// 1
+	dc.query(1, 3);							// 1
+	for(bool x : dc.solve()) cout << x << ' ';
+	cout << '\n';
+}
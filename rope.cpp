@@ -0,0 +1,415 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <chrono>
+
+using namespace std;
+using uint = unsigned int;
+
+// rope (persistent implicit treap)
+// it represents a sequence of elements (text) and keeps every version of it:
+// nodes are shared between versions and reference-counted, a node is copied
+// only when it is changed and shared (copy-on-write), so a copy of a rope
+// (snapshot) is O(1) and every operation copies O(logn) nodes.
+// every node keeps a chunk of 1..CHUNK consecutive elements (a node is
+// about one cache line, a chunk holds at least 2 elements though, so that
+// a full chunk can be cut in halves), a node shared by several places of
+// the sequence can't have a single priority, so merge picks the root at
+// random with the probability proportional to the sizes of the trees
+// all ropes with the same T share one arena (it isn't thread-safe), it is
+// freed when the last of their nodes is freed
+// insert, erase, get, substr, append	O(logn)
+// snapshot								O(1)
+template<typename T>
+class rope {
+
+	static constexpr uint CHUNK = sizeof(T) <= 22 ? 44 / sizeof(T) : 2;
+
+	struct node {
+		uint cnt;			// count of elements in the subtree
+		uint refs;			// count of links to the node (from parents and ropes)
+		uint left;			// left child
+		uint right;			// right child
+		uint len;			// count of elements in the chunk
+		T data[CHUNK];		// chunk of elements
+	};
+
+	using pnode = uint;	// index of node in the arena, 0 - null
+
+	struct arena {
+		vector<node> pool;		// pool[0] - null node
+		vector<pnode> free;		// freed nodes that can be reused
+		uint live;				// count of nodes in use
+		mt19937 rng;
+
+		arena(): pool(1, node{}), live(0), rng(chrono::steady_clock::now().time_since_epoch().count()) {}
+	};
+
+  private:
+	pnode root_;
+
+  public:
+	rope(): root_(0) {}
+
+	// builds the given sequence ( in O(n) )
+	rope(const vector<T>& arr): rope(arr.begin(), arr.end()) {}
+
+	// builds the sequence of the range ( in O(n) )
+	template<typename It>
+	rope(It first, It last): rope() {
+		vector<pnode> chunks;
+		while(first != last) {
+			pnode t = newNode();
+			node& nd = P(t);
+			for(; first != last && nd.len < CHUNK; ++first) nd.data[nd.len++] = *first;
+			nd.cnt = nd.len;
+			chunks.push_back(t);
+		}
+		root_ = build(chunks, 0, chunks.size());
+	}
+
+	// shares all nodes with the given rope ( in O(1) )
+	rope(const rope& r): root_(r.root_) { acquire(root_); }
+
+	rope& operator=(const rope& r) {
+		acquire(r.root_);
+		release(root_);
+		root_ = r.root_;
+		return *this;
+	}
+
+	~rope() { release(root_); }
+
+	// returns the copy of the current version ( in O(1) )
+	rope snapshot() const { return *this; }
+
+	// returns the count of elements
+	uint size() const { return root_ == 0 ? 0 : P(root_).cnt; }
+
+	// returns the pth element
+	T get(uint p) const {
+		pnode t = root_;
+		while(true) {
+			const node& nd = P(t);
+			uint lc = P(nd.left).cnt;
+			if(p < lc) {
+				t = nd.left;
+			} else if(p < lc + nd.len) {
+				return nd.data[p - lc];
+			} else {
+				p -= lc + nd.len;
+				t = nd.right;
+			}
+		}
+	}
+
+	// inserts a new element before the pth element (at the end if p > size())
+	// (a full chunk is cut into two halves, so chunks stay at least half full)
+	void insert(uint p, T x) {
+		p = min(p, size());
+		uint start, len;
+		if(!locate(root_, p, start, len)) {
+			root_ = newNode();
+			P(root_).data[0] = x;
+			P(root_).len = P(root_).cnt = 1;
+			return;
+		}
+		if(len < CHUNK) {
+			root_ = insertInternal(root_, p, x);
+			return;
+		}
+		// the cuts are at the bounds of the chunk, so tMid is its node only
+		pnode tLeft, tRight, tMid;
+		split(root_, start + len, tLeft, tRight);
+		split(tLeft, start, tLeft, tMid);
+		tMid = own(tMid);
+		pnode tail = newNode();
+		node& nd = P(tMid);
+		node& nt = P(tail);
+		for(uint i = CHUNK / 2; i < nd.len; ++i) nt.data[i - CHUNK / 2] = nd.data[i];
+		nt.len = nt.cnt = nd.len - CHUNK / 2;
+		nd.len = nd.cnt = CHUNK / 2;
+		if(p - start <= CHUNK / 2) tMid = insertInternal(tMid, p - start, x);
+		else tail = insertInternal(tail, p - start - CHUNK / 2, x);
+		root_ = merge(merge(merge(tLeft, tMid), tail), tRight);
+	}
+
+	// inserts the sequence s before the pth element
+	void insert(uint p, const rope& s) {
+		pnode tLeft, tRight;
+		acquire(s.root_);
+		split(root_, p, tLeft, tRight);
+		root_ = merge(merge(tLeft, s.root_), tRight);
+	}
+
+	// appends the sequence s (s may be this rope)
+	void append(const rope& s) {
+		acquire(s.root_);
+		root_ = merge(root_, s.root_);
+	}
+
+	// erases the subsegment [l;r]
+	void erase(uint l, uint r) {
+		pnode tLeft, tRight, tMid;
+		split(root_, r+1, tLeft, tRight);
+		split(tLeft, l, tLeft, tMid);
+		release(tMid);
+		root_ = merge(tLeft, tRight);
+	}
+
+	// returns the subsegment [l;r] as a new rope (it shares nodes with this one)
+	rope substr(uint l, uint r) const {
+		pnode tLeft, tRight, tMid;
+		acquire(root_);
+		split(root_, r+1, tLeft, tRight);
+		split(tLeft, l, tLeft, tMid);
+		release(tLeft);
+		release(tRight);
+		rope res;
+		res.root_ = tMid;
+		return res;
+	}
+
+	// returns the sequence ( in O(n) )
+	vector<T> toVector() const {
+		vector<T> res;
+		res.reserve(size());
+		vector<pnode> st;
+		for(pnode t = root_; t != 0 || !st.empty(); ) {
+			if(t != 0) {
+				st.push_back(t);
+				t = P(t).left;
+				continue;
+			}
+			t = st.back();
+			st.pop_back();
+			res.insert(res.end(), P(t).data, P(t).data + P(t).len);
+			t = P(t).right;
+		}
+		return res;
+	}
+
+	// prints the sequence (without separators, as a text)
+	void print() const {
+		for(const T& x : toVector()) cout << x;
+		cout << '\n';
+	}
+
+  private:
+	// the arena exists while any node of T is in use
+	static arena*& instance() {
+		static arena* a = nullptr;
+		return a;
+	}
+
+	static arena& A() { return *instance(); }
+
+	// the reference is invalidated by newNode
+	static node& P(pnode t) { return A().pool[t]; }
+
+	static pnode newNode() {
+		if(instance() == nullptr) instance() = new arena();
+		arena& a = A();
+		++a.live;
+		pnode t;
+		if(a.free.empty()) {
+			a.pool.push_back(node{});
+			t = a.pool.size() - 1;
+		} else {
+			t = a.free.back();
+			a.free.pop_back();
+		}
+		P(t).cnt = P(t).len = P(t).left = P(t).right = 0;
+		P(t).refs = 1;
+		return t;
+	}
+
+	static void acquire(pnode t) {
+		if(t != 0) ++P(t).refs;
+	}
+
+	// drops one link to t, frees the nodes that are not linked anymore
+	static void release(pnode t) {
+		vector<pnode> st = {t};
+		while(!st.empty()) {
+			t = st.back();
+			st.pop_back();
+			if(t == 0 || --P(t).refs > 0) continue;
+			st.push_back(P(t).left);
+			st.push_back(P(t).right);
+			A().free.push_back(t);
+			if(--A().live == 0) {
+				delete instance();
+				instance() = nullptr;
+			}
+		}
+	}
+
+	// returns the node that can be changed instead of t:
+	// t itself if the link to it is the only one, its copy otherwise
+	static pnode own(pnode t) {
+		if(P(t).refs == 1) return t;
+		--P(t).refs;
+		node copy = P(t);
+		copy.refs = 1;
+		acquire(copy.left);
+		acquire(copy.right);
+		pnode c = newNode();
+		P(c) = copy;
+		return c;
+	}
+
+	static void updateCnt(pnode t) { P(t).cnt = P(P(t).left).cnt + P(t).len + P(P(t).right).cnt; }
+
+	static pnode build(const vector<pnode>& chunks, uint l, uint r) {
+		if(l == r) return 0;
+		uint m = l + (r - l) / 2;
+		pnode t = chunks[m];
+		pnode left = build(chunks, l, m);
+		pnode right = build(chunks, m + 1, r);
+		P(t).left = left;
+		P(t).right = right;
+		updateCnt(t);
+		return t;
+	}
+
+	// finds the chunk where the element has to be inserted before the pth element
+	// (p <= count of elements of t), start - index of its first element, len - its size
+	static bool locate(pnode t, uint p, uint& start, uint& len) {
+		start = 0;
+		while(t != 0) {
+			const node& nd = P(t);
+			uint lc = P(nd.left).cnt;
+			if(p >= lc && p <= lc + nd.len) {
+				start += lc;
+				len = nd.len;
+				return true;
+			}
+			if(p < lc) {
+				t = nd.left;
+			} else {
+				p -= lc + nd.len;
+				start += lc + nd.len;
+				t = nd.right;
+			}
+		}
+		return false;
+	}
+
+	// inserts x into the chunk found by locate, the link to t is consumed
+	static pnode insertInternal(pnode t, uint p, T x) {
+		t = own(t);
+		uint lc = P(P(t).left).cnt;
+		if(p >= lc && p <= lc + P(t).len) {
+			node& nd = P(t);
+			for(uint i = nd.len; i > p - lc; --i) nd.data[i] = nd.data[i - 1];
+			nd.data[p - lc] = x;
+			++nd.len;
+		} else if(p < lc) {
+			pnode left = insertInternal(P(t).left, p, x);
+			P(t).left = left;
+		} else {
+			pnode right = insertInternal(P(t).right, p - lc - P(t).len, x);
+			P(t).right = right;
+		}
+		updateCnt(t);
+		return t;
+	}
+
+	// splits t into t1 (first x0 elements) and t2 (the rest), a chunk is cut
+	// into two nodes if needed; the link to t is consumed, t1 and t2 are new links
+	static void split(pnode t, uint x0, pnode& t1, pnode& t2) {
+		if(t == 0) {
+			t1 = t2 = 0;
+			return;
+		}
+		uint lc = P(P(t).left).cnt;
+		if(x0 == 0 || x0 >= P(t).cnt) {
+			t1 = x0 == 0 ? 0 : t;
+			t2 = x0 == 0 ? t : 0;
+			return;
+		}
+		t = own(t);
+		if(x0 <= lc) {
+			pnode right;
+			split(P(t).left, x0, t1, right);
+			P(t).left = right;
+			t2 = t;
+		} else if(x0 >= lc + P(t).len) {
+			pnode left;
+			split(P(t).right, x0 - lc - P(t).len, left, t2);
+			P(t).right = left;
+			t1 = t;
+		} else {
+			// the cut is inside the chunk: the tail goes to a new node
+			uint o = x0 - lc;
+			pnode tail = newNode();
+			node& nd = P(t);
+			node& nt = P(tail);
+			for(uint i = o; i < nd.len; ++i) nt.data[i - o] = nd.data[i];
+			nt.len = nd.len - o;
+			nt.right = nd.right;
+			nd.len = o;
+			nd.right = 0;
+			updateCnt(tail);
+			t1 = t;
+			t2 = tail;
+		}
+		updateCnt(t);
+	}
+
+	// merges t1 and t2, the links to them are consumed
+	static pnode merge(pnode t1, pnode t2) {
+		if(t1 == 0) return t2;
+		if(t2 == 0) return t1;
+		uint c1 = P(t1).cnt, c2 = P(t2).cnt;
+		if(A().rng() % (c1 + c2) < c1) {
+			t1 = own(t1);
+			pnode right = merge(P(t1).right, t2);
+			P(t1).right = right;
+			updateCnt(t1);
+			return t1;
+		}
+		t2 = own(t2);
+		pnode left = merge(t1, P(t2).left);
+		P(t2).left = left;
+		updateCnt(t2);
+		return t2;
+	}
+};
+
+int main() {
+
+	string s = "hello world";
+	rope<char> text(s.begin(), s.end());
+
+	rope<char> v0 = text.snapshot();	// O(1)
+	text.insert(5, ',');
+	text.print();						// hello, world
+	rope<char> v1 = text.snapshot();
+	text.erase(0, 6);					// erase "hello, "
+	text.insert(0, 'W');
+	text.erase(1, 1);
+	text.print();						// World
+
+	rope<char> hi = v1.substr(0, 4);	// hello
+	hi.insert(0, 'O');
+	hi.erase(1, 1);
+	hi.append(text);
+	hi.print();							// OelloWorld
+
+	v0.print();							// hello world
+	v1.print();							// hello, world
+	cout << v1.get(7) << ' ' << v1.size() << "\n\n";	// w 12
+
+	// lines of a text (a string is too big for a cache line, 2 per chunk)
+	rope<string> lines(vector<string>{"one", "two", "four"});
+	rope<string> old = lines.snapshot();
+	lines.insert(2, "three");
+	lines.insert(100, "five");			// p > size(): at the end
+	for(const string& l : lines.toVector()) cout << l << ' ';
+	cout << '\n';						// one two three four five
+	cout << old.size() << ' ' << old.get(2) << '\n';	// 3 four
+}
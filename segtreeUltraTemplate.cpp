@@ -1,6 +1,8 @@
 #include <iostream>
 #include <vector>
-#include <functional>
+#include <limits>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 using ll = long long;
@@ -8,101 +10,119 @@ using ull = unsigned long long;
 
 // segtree - a struct for
 // computing a target function on any subvector (sum/min/max)
-// and updating any subsegment (set*/add)
-// *by default
-// build, changeUpdMode		O(n)
-// get, update				O(logn)
-template<typename T, typename targetFunctor = plus<T>> 
+// and updating any subsegment (set/add/affine...)
+// the behaviour is defined by the policy (see examples below):
+//   op(a, b)			- target function (has to be associative)
+//   id()				- identity element of op (its type T is the type of the value)
+//   apply(a, u, len)	- applies update u to value a of the subsegment of length len,
+//						  returns false if the value can't be recomputed at once
+//						  (then the update is passed to the children; see beats)
+//   compose(u, v)		- update that equals to v followed by u
+//   updId()			- update that changes nothing (its type U is the type of the update)
+//   inv(a)				- inverse of a for op (optional, needed by getBatch only)
+// build	O(n) (O(n/threads) with threads)
+// get, update			O(logn) (amortized O(log^2n) for beats)
+// getBatch				O(min(qlogq, q + n) + count of visited nodes)
+template<typename policy>
 class segtree {
-	
-	enum segtreeUpdMode {
-		SET,
-		ADD
-	};
-	
+
+	using T = decltype(policy::id());
+	using U = decltype(policy::updId());
+
   private:
 	ull n_;
-	vector<T> data_, delay_;
-	targetFunctor targetF_;
-	segtreeUpdMode updMode_;
+	vector<T> data_;
+	vector<U> delay_;		// update that has to be pushed to the children
+	vector<char> hasDelay_;	// is there any update in delay_?
 
   public:
-	// build segment tree over the empty vector of size _n
-	segtree(ull n): n_(n), data_(4 * n, T()), delay_(4 * n, T()) {}
-	
+	// build segment tree over the vector of size _n filled with T()
+	segtree(ull n): segtree(vector<T>(n, T())) {}
+
 	// builds segment tree over the given vector
-	segtree(const vector<T>& a): segtree(a.size()) {
-		targetF_ = targetFunctor();
-		updMode_ = SET;
-		build(1, 1, n_, a); 
-	}
-	
-	// switches update mode to ADD ( in O(n) )
-	void switchUpdateModeToAdd() {
-		pushAll(1, 1, n_);
-		updMode_ = ADD;
-	}
-	
-	// switches update mode to SET ( in O(n) )
-	void switchUpdateModeToSet() {
-		pushAll(1, 1, n_);
-		updMode_ = SET;
+	// (subtrees of the top levels are built by different threads)
+	segtree(const vector<T>& a, ull threads = 1): n_(a.size()), data_(4 * n_, policy::id()),
+			delay_(4 * n_, policy::updId()), hasDelay_(4 * n_, false) {
+		build(1, 1, n_, a, threads);
 	}
-	
+
 	// returns the pth element of the vector
 	T get(ull p) { return getInternal(1, 1, n_, p, p); }
-	
-	// computes the getFunction on subvector [ql; qr]
+
+	// computes the target function on subvector [ql; qr]
 	T get(ull l, ull r) { return getInternal(1, 1, n_, l, r); }
-	
-	// executes updFunction on the pth element of the vector
-	void update(ull p, T x) { updateInternal(1, 1, n_, p, p, x); }
-	
-	// executes updFunction on the elements of subvector [l; r]
-	void update(ull l, ull r, T x) { updateInternal(1, 1, n_, l, r, x); }
-	
+
+	// applies update x to the pth element of the vector
+	void update(ull p, U x) { updateInternal(1, 1, n_, p, p, x); }
+
+	// applies update x to the elements of subvector [l; r]
+	void update(ull l, ull r, U x) { updateInternal(1, 1, n_, l, r, x); }
+
+	// computes the target function on subvectors [l; r] of all queries
+	// as op(inv(prefix(l-1)), prefix(r)) (as getBatch of segtree.cpp does):
+	// the ends of the prefixes are sorted and all the prefixes are computed
+	// in one traversal of the tree, so the shared parts of the paths are
+	// pushed and read once per batch (op has to have inv, e.g. sums)
+	vector<T> getBatch(const vector<pair<ull, ull>>& qs) {
+		vector<pair<ull, ull>> pts;		// {p, i}: prefix [1; p] goes to pre[i]
+		for(ull i = 0; i < qs.size(); ++i) {
+			pts.push_back({qs[i].second, i*2});
+			if(qs[i].first > 1) pts.push_back({qs[i].first - 1, i*2+1});
+		}
+		sortEnds(pts);
+		vector<T> pre(qs.size() * 2, policy::id());
+		if(!pts.empty()) getBatchInternal(1, 1, n_, pts.begin(), pts.end(), policy::id(), pre);
+		vector<T> res(qs.size());
+		for(ull i = 0; i < qs.size(); ++i) res[i] = policy::op(policy::inv(pre[i*2+1]), pre[i*2]);
+		return res;
+	}
+
   private:
-	void build(ull id, ull l, ull r, const vector<T>& a) {
+	void build(ull id, ull l, ull r, const vector<T>& a, ull threads) {
 		if(l == r) {
 			data_[id] = a[l - 1];
 			return;
 		}
 		ull m = (l+r)/2;
-		build(id*2, l, m, a);
-		build(id*2+1, m+1, r, a);
-		data_[id] = targetF_(data_[id*2], data_[id*2+1]);
+		if(threads > 1 && r - l >= (1 << 16)) {
+			thread t([&] { build(id*2, l, m, a, threads / 2); });
+			build(id*2+1, m+1, r, a, threads - threads / 2);
+			t.join();
+		} else {
+			build(id*2, l, m, a, 1);
+			build(id*2+1, m+1, r, a, 1);
+		}
+		data_[id] = policy::op(data_[id*2], data_[id*2+1]);
 	}
-	
-	T doRangedGet(ull l, ull r, T x) {
-		if(x == targetF_(x, x)) return x;
-		if(2*x == targetF_(x, x)) return x*(r-l+1);
-		cout << "RANGED GET ERROR\n";
-		return T();
+
+	void applyNode(ull id, ull l, ull r, const U& x) {
+		if(!policy::apply(data_[id], x, r-l+1)) {
+			push(id, l, r);
+			ull m = (l+r)/2;
+			applyNode(id*2, l, m, x);
+			applyNode(id*2+1, m+1, r, x);
+			data_[id] = policy::op(data_[id*2], data_[id*2+1]);
+			return;
+		}
+		if(l == r) return;
+		delay_[id] = hasDelay_[id] ? policy::compose(x, delay_[id]) : x;
+		hasDelay_[id] = true;
 	}
-	
-	T updateVal(T a, T b) { return updMode_ == ADD ? (a + b) : b; }
-	
+
 	void push(ull id, ull l, ull r) {
-		if(delay_[id] == T()) return;
-		if(id*2 < 4*n_) delay_[id*2] = updateVal(delay_[id*2], delay_[id]);
-		if(id*2+1 < 4*n_) delay_[id*2+1] = updateVal(delay_[id*2+1], delay_[id]);
-		data_[id] = updateVal(data_[id], doRangedGet(l, r, delay_[id]));
-		delay_[id] = T();
-	}
-	
-	void pushAll(ull id, ull l, ull r) {
-		push(id, l, r);
-		if(l == r) return;
+		if(!hasDelay_[id]) return;
 		ull m = (l+r)/2;
-		pushAll(id*2, l, m);
-		pushAll(id*2+1, m+1, r);
+		applyNode(id*2, l, m, delay_[id]);
+		applyNode(id*2+1, m+1, r, delay_[id]);
+		delay_[id] = policy::updId();
+		hasDelay_[id] = false;
 	}
-	
+
 	T getInternal(ull id, ull l, ull r, ull ql, ull qr) {
-		push(id, l, r);
 		if(ql <= l && qr >= r) {
 			return data_[id];
 		}
+		push(id, l, r);
 		ull m = (l+r)/2;
 		if(qr <= m) {
 			return getInternal(id*2, l, m, ql, qr);
@@ -110,51 +130,244 @@ class segtree {
 		if(ql >= m+1) {
 			return getInternal(id*2+1, m+1, r, ql, qr);
 		}
-		return targetF_(getInternal(id*2, l, m, ql, qr), getInternal(id*2+1, m+1, r, ql, qr));
+		return policy::op(getInternal(id*2, l, m, ql, qr), getInternal(id*2+1, m+1, r, ql, qr));
 	}
-	
-	void updateInternal(ull id, ull l, ull r, ull ql, ull qr, T x) {
+
+	// sorts the ends of prefixes (a counting sort if there are many of them)
+	void sortEnds(vector<pair<ull, ull>>& pts) {
+		if(pts.size() * 8 < n_) {
+			sort(pts.begin(), pts.end());
+			return;
+		}
+		vector<ull> start(n_ + 2, 0);
+		for(auto& pt : pts) ++start[pt.first + 1];
+		for(ull p = 1; p < start.size(); ++p) start[p] += start[p-1];
+		vector<pair<ull, ull>> res(pts.size());
+		for(auto& pt : pts) res[start[pt.first]++] = pt;
+		pts.swap(res);
+	}
+
+	// [b; e) - sorted ends of prefixes inside [l; r], acc - prefix [1; l-1]
+	template<typename It>
+	void getBatchInternal(ull id, ull l, ull r, It b, It e, T acc, vector<T>& pre) {
+		for(; b != e && prev(e)->first == r; --e) pre[prev(e)->second] = policy::op(acc, data_[id]);
+		if(b == e) return;
 		push(id, l, r);
+		ull m = (l+r)/2;
+		It mid = partition_point(b, e, [m](const pair<ull, ull>& pt) { return pt.first <= m; });
+		if(b != mid) getBatchInternal(id*2, l, m, b, mid, acc, pre);
+		if(mid != e) getBatchInternal(id*2+1, m+1, r, mid, e, policy::op(acc, data_[id*2]), pre);
+	}
+
+	void updateInternal(ull id, ull l, ull r, ull ql, ull qr, const U& x) {
 		if(ql > r || qr < l) return;
 		if(ql <= l && qr >= r) {
-			delay_[id] = updateVal(delay_[id], x);
-			push(id, l, r);
+			applyNode(id, l, r, x);
 			return;
 		}
+		push(id, l, r);
 		ull m = (l+r)/2;
 		updateInternal(id*2, l, m, ql, qr, x);
 		updateInternal(id*2+1, m+1, r, ql, qr, x);
-		data_[id] = targetF_(data_[id*2], data_[id*2+1]);
+		data_[id] = policy::op(data_[id*2], data_[id*2+1]);
 	}
 };
 
+// sum + add
+template<typename T>
+struct sumAdd {
+	static T op(T a, T b) { return a + b; }
+	static T id() { return T(); }
+	static bool apply(T& a, T u, ull len) { a += u * T(len); return true; }
+	static T compose(T u, T v) { return u + v; }
+	static T updId() { return T(); }
+	static T inv(T a) { return -a; }
+};
+
+// sum + set
+template<typename T>
+struct sumSet {
+	static T op(T a, T b) { return a + b; }
+	static T id() { return T(); }
+	static bool apply(T& a, T u, ull len) { a = u * T(len); return true; }
+	static T compose(T u, T) { return u; }
+	static T updId() { return T(); }
+	static T inv(T a) { return -a; }
+};
+
+// min + add
+template<typename T>
+struct minAdd {
+	static T op(T a, T b) { return min(a, b); }
+	static T id() { return numeric_limits<T>::max(); }
+	static bool apply(T& a, T u, ull) { a += u; return true; }
+	static T compose(T u, T v) { return u + v; }
+	static T updId() { return T(); }
+};
+
+// max + set
+template<typename T>
+struct maxSet {
+	static T op(T a, T b) { return max(a, b); }
+	static T id() { return numeric_limits<T>::lowest(); }
+	static bool apply(T& a, T u, ull) { a = u; return true; }
+	static T compose(T u, T) { return u; }
+	static T updId() { return T(); }
+};
+
+// sum + affine update (x -> a*x + b)
 template<typename T>
-struct mx { T operator()(T a, T b) { return max(a, b); } };
+struct sumAffine {
+	static T op(T a, T b) { return a + b; }
+	static T id() { return T(); }
+	static bool apply(T& a, pair<T, T> u, ull len) { a = u.first * a + u.second * T(len); return true; }
+	static pair<T, T> compose(pair<T, T> u, pair<T, T> v) { return {u.first * v.first, u.first * v.second + u.second}; }
+	static pair<T, T> updId() { return {1, 0}; }
+	static T inv(T a) { return -a; }
+};
+
+// segment tree beats: sum/max/min + chmin/chmax/add
+// an update is x -> min(max(x + add, lo), hi); it can be applied to a node
+// only if chmax changes its minimums only and chmin changes its maximums only
+// (lo < second min, hi > second max), otherwise it goes to the children
+template<typename T>
+struct beats {
+	static constexpr T NEG = numeric_limits<T>::lowest();
+	static constexpr T POS = numeric_limits<T>::max();
+
+	struct node {
+		T sum;
+		T mx1, mx2;		// max and second (strictly less) max
+		T mn1, mn2;		// min and second (strictly greater) min
+		ull mxc, mnc;	// counts of max and min
+		node(T x = T()): sum(x), mx1(x), mx2(NEG), mn1(x), mn2(POS), mxc(1), mnc(1) {}
+	};
+
+	struct upd {
+		T add, lo, hi;
+	};
+
+	static upd add(T x) { return {x, NEG, POS}; }
+	static upd chmax(T x) { return {T(), x, POS}; }
+	static upd chmin(T x) { return {T(), NEG, x}; }
+
+	static node op(const node& a, const node& b) {
+		node c;
+		c.sum = a.sum + b.sum;
+		if(a.mx1 == b.mx1) c = withMax(c, a.mx1, max(a.mx2, b.mx2), a.mxc + b.mxc);
+		else if(a.mx1 > b.mx1) c = withMax(c, a.mx1, max(a.mx2, b.mx1), a.mxc);
+		else c = withMax(c, b.mx1, max(a.mx1, b.mx2), b.mxc);
+		if(a.mn1 == b.mn1) c = withMin(c, a.mn1, min(a.mn2, b.mn2), a.mnc + b.mnc);
+		else if(a.mn1 < b.mn1) c = withMin(c, a.mn1, min(a.mn2, b.mn1), a.mnc);
+		else c = withMin(c, b.mn1, min(a.mn1, b.mn2), b.mnc);
+		return c;
+	}
+
+	static node id() {
+		node a;
+		a.mx1 = NEG, a.mn1 = POS;
+		a.mxc = a.mnc = 0;
+		return a;
+	}
+
+	static bool apply(node& a, const upd& u, ull len) {
+		if(u.add != T()) {
+			a.sum += u.add * T(len);
+			a.mx1 += u.add, a.mx2 = shift(a.mx2, u.add);
+			a.mn1 += u.add, a.mn2 = shift(a.mn2, u.add);
+		}
+		if(u.lo > a.mn1) {
+			if(u.lo >= a.mn2) return false;
+			a.sum += (u.lo - a.mn1) * T(a.mnc);
+			if(a.mx1 == a.mn1) a.mx1 = u.lo;
+			else if(a.mx2 == a.mn1) a.mx2 = u.lo;
+			a.mn1 = u.lo;
+		}
+		if(u.hi < a.mx1) {
+			if(u.hi <= a.mx2) return false;
+			a.sum -= (a.mx1 - u.hi) * T(a.mxc);
+			if(a.mn1 == a.mx1) a.mn1 = u.hi;
+			else if(a.mn2 == a.mx1) a.mn2 = u.hi;
+			a.mx1 = u.hi;
+		}
+		return true;
+	}
+
+	static upd compose(const upd& u, const upd& v) {
+		return {v.add + u.add,
+				min(max(shift(v.lo, u.add), u.lo), u.hi),
+				min(max(shift(v.hi, u.add), u.lo), u.hi)};
+	}
+
+	static upd updId() { return add(T()); }
+
+  private:
+	// adds d to x unless x is infinite
+	static T shift(T x, T d) { return (x == NEG || x == POS) ? x : x + d; }
+
+	static node withMax(node c, T mx1, T mx2, ull mxc) {
+		c.mx1 = mx1, c.mx2 = mx2, c.mxc = mxc;
+		return c;
+	}
+
+	static node withMin(node c, T mn1, T mn2, ull mnc) {
+		c.mn1 = mn1, c.mn2 = mn2, c.mnc = mnc;
+		return c;
+	}
+};
 
 int main() {
 
 	vector<int> arr = {1, 2, 3, 4, 5, 6, 7, 8};
-	
-	segtree<int> segPlus(arr);
-	// equals to
-	// segtree<int, plus<int>> segPlus(arr);
-	
-	cout << segPlus.get(1, 3) << '\n';		// 6
-	cout << segPlus.get(4, 8) << '\n';		// 30
-	segPlus.update(1, 3);					// {3, 2, 3, 4, 5, 6, 7, 8}
-	cout << segPlus.get(1, 8) << "\n\n";	// 38
-	
-	segPlus.switchUpdateModeToAdd();
-	
-	cout << segPlus.get(1, 3) << '\n';		// 6
-	cout << segPlus.get(4, 8) << '\n';		// 30
-	segPlus.update(1, 8, 10);				// {11, 12, 13, 14, 15, 16, 17, 18}
-	cout << segPlus.get(1, 8) << "\n\n";	// 116 (+8*10)
-	
-	segtree<int, mx<int>> segMxS(arr);
-	
+
+	segtree<sumSet<int>> segPlusS(arr);
+
+	cout << segPlusS.get(1, 3) << '\n';		// 6
+	cout << segPlusS.get(4, 8) << '\n';		// 30
+	segPlusS.update(1, 3);					// {3, 2, 3, 4, 5, 6, 7, 8}
+	cout << segPlusS.get(1, 8) << '\n';		// 38
+	segPlusS.update(1, 4, 0);				// {0, 0, 0, 0, 5, 6, 7, 8}
+	cout << segPlusS.get(1, 8) << "\n\n";	// 26
+
+	segtree<sumAdd<int>> segPlusA(arr);
+
+	cout << segPlusA.get(1, 3) << '\n';		// 6
+	cout << segPlusA.get(4, 8) << '\n';		// 30
+	segPlusA.update(1, 8, 10);				// {11, 12, 13, 14, 15, 16, 17, 18}
+	cout << segPlusA.get(1, 8) << "\n\n";	// 116 (+8*10)
+
+	segtree<maxSet<int>> segMxS(arr);
+
 	cout << segMxS.get(1, 3) << '\n';		// 3
 	cout << segMxS.get(4, 8) << '\n';		// 8
 	segMxS.update(5, 8, 1);					// {1, 2, 3, 4, 1, 1, 1, 1}
-	cout << segMxS.get(1, 8) << '\n';		// 4
-}
\ No newline at end of file
+	cout << segMxS.get(1, 8) << "\n\n";		// 4
+
+	segtree<minAdd<int>> segMnA(arr);
+
+	segMnA.update(1, 4, 10);				// {11, 12, 13, 14, 5, 6, 7, 8}
+	cout << segMnA.get(1, 8) << '\n';		// 5
+	segMnA.update(5, 8, 10);				// {11, 12, 13, 14, 15, 16, 17, 18}
+	cout << segMnA.get(1, 8) << "\n\n";		// 11
+
+	segtree<sumAffine<ll>> segAff(vector<ll>(arr.begin(), arr.end()));
+
+	segAff.update(1, 4, {2, 1});			// {3, 5, 7, 9, 5, 6, 7, 8}
+	segAff.update(3, 6, {1, -1});			// {3, 5, 6, 8, 4, 5, 7, 8}
+	cout << segAff.get(1, 8) << '\n';		// 46
+	cout << segAff.get(3, 4) << '\n';		// 14
+	segAff.update(1, 8, {0, 1});			// {1, 1, 1, 1, 1, 1, 1, 1}
+	segAff.update(2, 3, {3, 0});			// {1, 3, 3, 1, 1, 1, 1, 1}
+	for(ll x : segAff.getBatch({{1, 8}, {2, 4}, {5, 5}})) cout << x << ' ';
+	cout << "\n\n";							// 12 7 1
+
+	segtree<beats<ll>> segB(vector<beats<ll>::node>(arr.begin(), arr.end()));
+
+	segB.update(1, 8, beats<ll>::chmin(5));		// {1, 2, 3, 4, 5, 5, 5, 5}
+	cout << segB.get(1, 8).sum << '\n';			// 30
+	segB.update(3, 6, beats<ll>::add(-3));		// {1, 2, 0, 1, 2, 2, 5, 5}
+	segB.update(1, 8, beats<ll>::chmax(2));		// {2, 2, 2, 2, 2, 2, 5, 5}
+	cout << segB.get(1, 8).sum << '\n';			// 22
+	cout << segB.get(2, 6).mx1 << '\n';			// 2
+	cout << segB.get(6, 8).mn1 << '\n';			// 2
+}
@@ -1,90 +1,423 @@
 #include <iostream>
+#include <vector>
 #include <chrono>
 #include <random>
+#include <algorithm>
+#include <thread>
+#include <iterator>
 
 using namespace std;
+using uint = unsigned int;
 
 // treap (cartesian tree)
 // it represents a set of elements (the pathetic parody of inimitable std::set)
+// nodes are stored in the arena of the tree and refer to each other by 32-bit
+// indices, erased nodes are reused, the whole tree is freed at once
+// insert, erase, kth, rank, lowerBound	O(logn)
+// unite, intersect, subtract			O(mlog(n/m + 1)) (+ O(m) to move the nodes of the other tree)
 template<typename T>
 class treap {
 	
 	struct node {
 		T val;		    // (x) value of node
 		int prior;		// (y) priority of node (used to achieve balancity of tree)
-		node* left;		// left child
-		node* right;	// right child
+		uint cnt;		// count of nodes in the subtree
+		uint left;		// left child
+		uint right;		// right child
 		
-		node(T _val, int _prior): val(_val), prior(_prior) {
-			left = right = nullptr;
+		node(T _val, int _prior): val(_val), prior(_prior), cnt(1) {
+			left = right = 0;
 		}
 	};
 	
-	using pnode = node*;
+	using pnode = uint;	// index of node in pool_, 0 - null
+	
+	// state of one thread of an operation
+	struct context {
+		vector<pnode> path;		// nodes visited by the last split/merge
+		vector<pnode> freed;	// roots of the subtrees to free
+	};
 	
   private:
 	pnode root_;
 	mt19937 rng_;
+	vector<node> pool_;		// arena of nodes (pool_[0] - null node)
+	vector<pnode> free_;	// roots of the erased subtrees, their nodes are reused
+	context ctx_;
 	
   public:
+	// in-order iterator (it is invalidated by any change of the tree)
+	class iterator {
+		
+		friend class treap;
+		
+	  private:
+		const treap* tr_;
+		vector<pnode> st_;	// ancestors whose left subtree contains the current node, top - current node
+		
+		iterator(const treap* tr, vector<pnode> st): tr_(tr), st_(st) {}
+		
+	  public:
+		using iterator_category = forward_iterator_tag;
+		using value_type = T;
+		using difference_type = ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+		
+		const T& operator*() const { return tr_->pool_[st_.back()].val; }
+		
+		iterator& operator++() {
+			pnode t = tr_->pool_[st_.back()].right;
+			st_.pop_back();
+			tr_->pushLeftSpine(t, st_);
+			return *this;
+		}
+		
+		bool operator==(const iterator& it) const {
+			if(st_.empty() || it.st_.empty()) return st_.empty() == it.st_.empty();
+			return st_.back() == it.st_.back();
+		}
+		
+		bool operator!=(const iterator& it) const { return !(*this == it); }
+	};
+	
 	treap() {
-		root_ = nullptr;
+		root_ = 0;
 		rng_ = mt19937(chrono::steady_clock::now().time_since_epoch().count());
+		pool_.emplace_back(T(), 0);
+		pool_[0].cnt = 0;
+	}
+	
+	// builds the set of the given elements ( in O(nlogn) for sorting )
+	treap(vector<T> arr): treap() {
+		sort(arr.begin(), arr.end());
+		arr.erase(unique(arr.begin(), arr.end()), arr.end());
+		assign(arr.begin(), arr.end());
+	}
+	
+	// replaces the set with the elements of the sorted range without duplicates ( in O(n) )
+	template<typename It>
+	void assign(It first, It last) {
+		clear();
+		root_ = build(first, last);
 	}
 	
+	// erases all elements and frees all nodes
+	void clear() {
+		pool_.erase(pool_.begin() + 1, pool_.end());
+		free_.clear();
+		root_ = 0;
+	}
+	
+	// reserves memory for n nodes
+	void reserve(uint n) { pool_.reserve(n + 1); }
+	
+	// returns the count of elements
+	uint size() { return pool_[root_].cnt; }
+	
 	// prints the set values
 	void print() { printInternal(root_); cout << '\n'; } 
 	
 	// inserts a new element 
 	void insert(T x) {
-		pnode tLeft = nullptr, tRight = nullptr;
-		pnode tNew = new node(x, rng_());
-		split(root_, x, tLeft, tRight);
-		root_ = merge(tLeft, merge(tNew, tRight));
+		pnode tLeft = 0, tRight = 0;
+		pnode tNew = newNode(x);
+		split(root_, x, tLeft, tRight, false, ctx_.path);
+		root_ = merge(tLeft, merge(tNew, tRight, ctx_.path), ctx_.path);
 	}
 	
 	// erases the element
 	void erase(T x) {
 		pnode tLeft, tRight, tMid;
-		tLeft = tRight = tMid = nullptr;
-		split(root_, x, tLeft, tRight, true);
-		split(tLeft, x, tLeft, tMid, false);
-		delete tMid;
-		root_ = merge(tLeft, tRight);
+		tLeft = tRight = tMid = 0;
+		split(root_, x, tLeft, tRight, true, ctx_.path);
+		split(tLeft, x, tLeft, tMid, false, ctx_.path);
+		if(tMid != 0) free_.push_back(tMid);
+		root_ = merge(tLeft, tRight, ctx_.path);
+	}
+	
+	// returns the kth (from 0) smallest element
+	T kth(uint k) {
+		pnode t = root_;
+		while(k != pool_[pool_[t].left].cnt) {
+			if(k < pool_[pool_[t].left].cnt) {
+				t = pool_[t].left;
+			} else {
+				k -= pool_[pool_[t].left].cnt + 1;
+				t = pool_[t].right;
+			}
+		}
+		return pool_[t].val;
+	}
+	
+	// returns the count of elements less than x
+	uint rank(T x) {
+		uint res = 0;
+		for(pnode t = root_; t != 0; ) {
+			if(pool_[t].val < x) {
+				res += pool_[pool_[t].left].cnt + 1;
+				t = pool_[t].right;
+			} else {
+				t = pool_[t].left;
+			}
+		}
+		return res;
+	}
+	
+	iterator begin() const {
+		vector<pnode> st;
+		pushLeftSpine(root_, st);
+		return iterator(this, st);
+	}
+	
+	iterator end() const { return iterator(this, {}); }
+	
+	// returns the iterator to the first element not less than x
+	iterator lowerBound(T x) const {
+		vector<pnode> st;
+		for(pnode t = root_; t != 0; ) {
+			if(pool_[t].val < x) {
+				t = pool_[t].right;
+			} else {
+				st.push_back(t);
+				t = pool_[t].left;
+			}
+		}
+		return iterator(this, st);
+	}
+	
+	// adds all elements of the other set, the other set becomes empty
+	// (the recursion is split between threads for large trees)
+	void unite(treap& other, uint threads = 1) {
+		if(&other == this) return;
+		pnode b = absorb(other);
+		root_ = uniteInternal(root_, b, ctx_, threads);
+		release(ctx_);
+	}
+	
+	// keeps the elements that are in the other set too, the other set becomes empty
+	void intersect(treap& other, uint threads = 1) {
+		if(&other == this) return;
+		pnode b = absorb(other);
+		root_ = intersectInternal(root_, b, ctx_, threads);
+		release(ctx_);
+	}
+	
+	// erases the elements of the other set, the other set becomes empty
+	void subtract(treap& other, uint threads = 1) {
+		if(&other == this) return clear();
+		pnode b = absorb(other);
+		root_ = subtractInternal(root_, b, ctx_, threads);
+		release(ctx_);
 	}
 	
   private:
-	void split(pnode t, T x, pnode& t1, pnode& t2, bool xToLeft = false) {
-		if(t == nullptr) {
-			t2 = t1 = nullptr;
+	pnode newNode(T x) {
+		if(free_.empty()) {
+			pool_.emplace_back(x, rng_());
+			return pool_.size() - 1;
+		}
+		pnode t = free_.back();
+		free_.pop_back();
+		if(pool_[t].left != 0) free_.push_back(pool_[t].left);
+		if(pool_[t].right != 0) free_.push_back(pool_[t].right);
+		pool_[t] = node(x, rng_());
+		return t;
+	}
+	
+	void updateCnt(pnode t) { pool_[t].cnt = 1 + pool_[pool_[t].left].cnt + pool_[pool_[t].right].cnt; }
+	
+	void pushLeftSpine(pnode t, vector<pnode>& st) const {
+		for(; t != 0; t = pool_[t].left) st.push_back(t);
+	}
+	
+	// builds the treap over the sorted range in O(n):
+	// the stack keeps the right spine, a new node becomes the right child of the
+	// last spine node with greater priority, the popped part becomes its left child;
+	// a popped subtree never changes again, so its cnt is computed on pop
+	template<typename It>
+	pnode build(It first, It last) {
+		vector<pnode> st;
+		for(; first != last; ++first) {
+			pnode t = newNode(*first);
+			pnode popped = 0;
+			while(!st.empty() && pool_[st.back()].prior < pool_[t].prior) {
+				popped = st.back();
+				st.pop_back();
+				updateCnt(popped);
+			}
+			pool_[t].left = popped;
+			if(!st.empty()) pool_[st.back()].right = t;
+			st.push_back(t);
+		}
+		for(uint i = st.size(); i-- > 0; ) updateCnt(st[i]);
+		return st.empty() ? 0 : st[0];
+	}
+	
+	// moves the nodes of the other tree to the arena, returns the new root
+	pnode absorb(treap& other) {
+		vector<pnode> order, st;
+		if(other.root_ != 0) st.push_back(other.root_);
+		while(!st.empty()) {
+			pnode t = st.back();
+			st.pop_back();
+			order.push_back(t);
+			if(other.pool_[t].left != 0) st.push_back(other.pool_[t].left);
+			if(other.pool_[t].right != 0) st.push_back(other.pool_[t].right);
+		}
+		vector<pnode> newId(other.pool_.size(), 0);
+		for(uint i = 0; i < order.size(); ++i) newId[order[i]] = pool_.size() + i;
+		for(pnode t : order) {
+			node nd = other.pool_[t];
+			nd.left = newId[nd.left];
+			nd.right = newId[nd.right];
+			pool_.push_back(nd);
+		}
+		pnode res = newId[other.root_];
+		other.clear();
+		return res;
+	}
+	
+	// frees the subtrees collected by an operation
+	void release(context& c) {
+		free_.insert(free_.end(), c.freed.begin(), c.freed.end());
+		c.freed.clear();
+	}
+	
+	// runs f(c, threads) and g(c, threads) for two disjoint subtrees,
+	// f is run by a new thread if threads are available and the subtrees are large
+	template<typename F, typename G>
+	void fork(F f, G g, context& c, uint threads, uint size) {
+		if(threads < 2 || size < (1 << 14)) {
+			f(c, 1);
+			g(c, 1);
 			return;
 		}
-		if((!xToLeft && x > t->val)||(xToLeft && x >= t->val)) {
-			split(t->right, x, t->right, t2, xToLeft);
-			t1 = t;
-		} else {
-			split(t->left, x, t1, t->left, xToLeft);
-			t2 = t;
+		context fc;
+		thread th([&] { f(fc, threads / 2); });
+		g(c, threads - threads / 2);
+		th.join();
+		c.freed.insert(c.freed.end(), fc.freed.begin(), fc.freed.end());
+	}
+	
+	pnode uniteInternal(pnode a, pnode b, context& c, uint threads) {
+		if(a == 0) return b;
+		if(b == 0) return a;
+		if(pool_[a].prior < pool_[b].prior) swap(a, b);
+		pnode bl, bm, br;
+		split(b, pool_[a].val, bl, bm, false, c.path);
+		split(bm, pool_[a].val, bm, br, true, c.path);
+		if(bm != 0) c.freed.push_back(bm);
+		pnode al = pool_[a].left, ar = pool_[a].right, l, r;
+		fork([&](context& fc, uint th) { l = uniteInternal(al, bl, fc, th); },
+			[&](context& gc, uint th) { r = uniteInternal(ar, br, gc, th); },
+			c, threads, pool_[a].cnt + pool_[b].cnt);
+		pool_[a].left = l;
+		pool_[a].right = r;
+		updateCnt(a);
+		return a;
+	}
+	
+	pnode intersectInternal(pnode a, pnode b, context& c, uint threads) {
+		if(a == 0 || b == 0) {
+			if(a != 0) c.freed.push_back(a);
+			if(b != 0) c.freed.push_back(b);
+			return 0;
+		}
+		if(pool_[a].prior < pool_[b].prior) swap(a, b);
+		pnode bl, bm, br;
+		split(b, pool_[a].val, bl, bm, false, c.path);
+		split(bm, pool_[a].val, bm, br, true, c.path);
+		pnode al = pool_[a].left, ar = pool_[a].right, l, r;
+		fork([&](context& fc, uint th) { l = intersectInternal(al, bl, fc, th); },
+			[&](context& gc, uint th) { r = intersectInternal(ar, br, gc, th); },
+			c, threads, pool_[a].cnt + pool_[b].cnt);
+		if(bm == 0) {
+			freeNode(a, c);
+			return merge(l, r, c.path);
 		}
+		c.freed.push_back(bm);
+		pool_[a].left = l;
+		pool_[a].right = r;
+		updateCnt(a);
+		return a;
 	}
 	
-	pnode merge(pnode t1, pnode t2) {
-		if(t1 == nullptr) return t2;
-		if(t2 == nullptr) return t1;
-		if(t1->prior > t2->prior) {
-			t1->right = merge(t1->right, t2);
-			return t1;
-		} else {
-			t2->left = merge(t1, t2->left);
-			return t2;
+	pnode subtractInternal(pnode a, pnode b, context& c, uint threads) {
+		if(a == 0 || b == 0) {
+			if(b != 0) c.freed.push_back(b);
+			return a;
 		}
+		pnode al, am, ar;
+		split(a, pool_[b].val, al, am, false, c.path);
+		split(am, pool_[b].val, am, ar, true, c.path);
+		if(am != 0) c.freed.push_back(am);
+		pnode bl = pool_[b].left, br = pool_[b].right, l, r;
+		fork([&](context& fc, uint th) { l = subtractInternal(al, bl, fc, th); },
+			[&](context& gc, uint th) { r = subtractInternal(ar, br, gc, th); },
+			c, threads, pool_[a].cnt + pool_[b].cnt);
+		freeNode(b, c);
+		return merge(l, r, c.path);
+	}
+	
+	// frees the node t only (its children are already reused)
+	void freeNode(pnode t, context& c) {
+		pool_[t].left = pool_[t].right = 0;
+		c.freed.push_back(t);
+	}
+	
+	// splits t into t1 (< x or <= x) and t2 (the rest) top-down:
+	// l and r point to the links where the next parts of t1 and t2 are attached,
+	// then cnt of the visited nodes is recomputed from the bottom
+	void split(pnode t, T x, pnode& t1, pnode& t2, bool xToLeft, vector<pnode>& path) {
+		pnode* l = &t1;
+		pnode* r = &t2;
+		path.clear();
+		while(t != 0) {
+			path.push_back(t);
+			if((!xToLeft && x > pool_[t].val)||(xToLeft && x >= pool_[t].val)) {
+				*l = t;
+				l = &pool_[t].right;
+				t = pool_[t].right;
+			} else {
+				*r = t;
+				r = &pool_[t].left;
+				t = pool_[t].left;
+			}
+		}
+		*l = *r = 0;
+		for(uint i = path.size(); i-- > 0; ) updateCnt(path[i]);
+	}
+	
+	// merges t1 and t2 (all elements of t1 are less) top-down:
+	// h points to the link where the next node of the result is attached
+	pnode merge(pnode t1, pnode t2, vector<pnode>& path) {
+		pnode res = 0;
+		pnode* h = &res;
+		path.clear();
+		while(t1 != 0 && t2 != 0) {
+			if(pool_[t1].prior > pool_[t2].prior) {
+				path.push_back(t1);
+				*h = t1;
+				h = &pool_[t1].right;
+				t1 = pool_[t1].right;
+			} else {
+				path.push_back(t2);
+				*h = t2;
+				h = &pool_[t2].left;
+				t2 = pool_[t2].left;
+			}
+		}
+		*h = (t1 != 0 ? t1 : t2);
+		for(uint i = path.size(); i-- > 0; ) updateCnt(path[i]);
+		return res;
 	}
 	
 	void printInternal(pnode t) {
-		if(t == nullptr) return;
-		printInternal(t->left);
-		cout << t->val  << ' ';
-		printInternal(t->right);
+		if(t == 0) return;
+		printInternal(pool_[t].left);
+		cout << pool_[t].val  << ' ';
+		printInternal(pool_[t].right);
 	}
 };
 
@@ -98,6 +431,24 @@ int main() {
 	t.erase(3);
 	t.print();
 	
+	treap<int> ts({7, 3, 9, 3, 1});
+	ts.print();							// 1 3 7 9
+	ts.assign(arr.begin(), arr.end());
+	ts.print();							// 1 2 3
+	
+	treap<int> a({1, 3, 5, 7, 9}), b({3, 4, 5, 6});
+	cout << a.kth(2) << ' ' << a.rank(6) << ' ' << *a.lowerBound(6) << '\n';	// 5 3 7
+	a.unite(b);
+	for(int x : a) cout << x << ' ';	// 1 3 4 5 6 7 9
+	cout << '\n';
+	treap<int> c({4, 5, 8, 9});
+	a.subtract(c);
+	a.print();							// 1 3 6 7
+	treap<int> d({0, 1, 2, 3, 4, 7});
+	a.intersect(d);
+	a.print();							// 1 3 7
+	cout << a.size() << '\n';			// 3
+	
 	treap<double> tt;
 	tt.insert(2.0002);
 	tt.insert(2.0004);
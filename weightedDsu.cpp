@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// weighted (potential) disjoint set union
+// keeps constraints x_v - x_u = w between the elements of a set: every element
+// stores its potential relative to its parent, find sums the potentials
+// up to the leader and links the path to it (with the summed potentials);
+// the potentials are elements of an abelian group defined by the policy:
+// id - neutral element (its type T is the type of potentials),
+// op - group operation, inv - inverse element
+// build O(n)
+// query O(α(n)) ~ O(1)
+template<typename group>
+class weightedDsu {
+
+	using T = decltype(group::id());
+
+	struct node {
+		int32_t leader;	// parent or -(size of set)
+		T pot;			// x_a - x_parent (id for the leader)
+	};
+
+  private:
+	vector<node> data_;
+
+  public:
+	weightedDsu(int n): data_(n, node{-1, group::id()}) {}
+
+	// finds the leader of set that contains the element a
+	int find(int a) {
+		T p;
+		return find(a, p);
+	}
+
+	// adds the constraint x_v - x_u = w
+	// returns false if it contradicts the previous ones (then it is ignored)
+	bool unite(int u, int v, T w) {
+		T pu, pv;
+		int lu = find(u, pu);
+		int lv = find(v, pv);
+		// x_lv - x_lu = w + pu - pv
+		T d = group::op(group::op(w, pu), group::inv(pv));
+		if(lu == lv) return d == group::id();
+		if(data_[lu].leader > data_[lv].leader) {	// sizes are negative
+			swap(lu, lv);
+			d = group::inv(d);
+		}
+		data_[lu].leader += data_[lv].leader;
+		data_[lv].leader = lu;
+		data_[lv].pot = d;
+		return true;
+	}
+
+	// checks whether x_v - x_u is known
+	bool same(int u, int v) { return find(u) == find(v); }
+
+	// returns x_v - x_u (the elements have to be in the same set)
+	T diff(int u, int v) {
+		T pu, pv;
+		find(u, pu);
+		find(v, pv);
+		return group::op(pv, group::inv(pu));
+	}
+
+  private:
+	// finds the leader l of set that contains the element a, p = x_a - x_l
+	int find(int a, T& p) {
+		int l = a;
+		p = group::id();
+		while(data_[l].leader >= 0) {
+			p = group::op(p, data_[l].pot);
+			l = data_[l].leader;
+		}
+		// every element of the path is linked to the leader,
+		// acc is x_a - x_l for the current element a
+		for(T acc = p; a != l; ) {
+			int next = data_[a].leader;
+			T nextAcc = group::op(acc, group::inv(data_[a].pot));
+			data_[a].leader = l;
+			data_[a].pot = acc;
+			a = next;
+			acc = nextAcc;
+		}
+		return l;
+	}
+};
+
+// integers with addition
+template<typename T>
+struct addGroup {
+	static T id() { return T(); }
+	static T op(T a, T b) { return a + b; }
+	static T inv(T a) { return -a; }
+};
+
+// bit masks with xor (every element is its own inverse)
+template<typename T>
+struct xorGroup {
+	static T id() { return T(); }
+	static T op(T a, T b) { return a ^ b; }
+	static T inv(T a) { return a; }
+};
+
+// residues modulo MOD with addition
+template<int64_t MOD>
+struct modAddGroup {
+	static int64_t id() { return 0; }
+	static int64_t op(int64_t a, int64_t b) { return (a + b) % MOD; }
+	static int64_t inv(int64_t a) { return (MOD - a) % MOD; }
+};
+
+int main() {
+
+	weightedDsu<addGroup<int64_t>> d(4);
+	d.unite(0, 1, 5);							// x1 - x0 = 5
+	d.unite(1, 2, -2);							// x2 - x1 = -2
+	cout << d.diff(0, 2) << '\n';				// 3
+	cout << d.unite(2, 0, -3) << ' ' << d.unite(0, 2, 4) << '\n';	// 1 0
+	cout << d.same(0, 3) << "\n\n";				// 0
+
+	weightedDsu<xorGroup<int>> x(3);
+	x.unite(0, 1, 6);
+	x.unite(1, 2, 3);
+	cout << x.diff(0, 2) << '\n';				// 5
+
+	weightedDsu<modAddGroup<7>> m(3);
+	m.unite(0, 1, 5);
+	m.unite(1, 2, 4);
+	cout << m.diff(0, 2) << ' ' << m.diff(2, 0) << '\n';	// 2 5
+}
@@ -0,0 +1,107 @@
+#pragma GCC target("avx2")
+#include <iostream>
+#include <vector>
+#include <type_traits>
+
+using namespace std;
+using ll = long long;
+using ull = unsigned long long;
+
+// wide segtree
+// point update and range sum on a tree with fanout B = 64 / sizeof(T)
+// (16 for int, 8 for ll), so every node is exactly one cache line.
+// node[j] keeps the sum of the children 0..j-1 of the node, so:
+// - a prefix sum reads one value per level (log_B(n) levels),
+// - an update adds x to node[j] for all j > child, which is a masked
+//   add over the whole cache line (two AVX2 instructions per level)
+// build	O(n)
+// get		O(log_B(n))
+// update	O(log_B(n)) (point only)
+template<typename T>
+class wideSegtree {
+
+	static_assert(is_integral<T>::value, "T has to be integral (masks are used)");
+
+	static constexpr ull B = 64 / sizeof(T);
+
+	typedef T vec __attribute__((vector_size(32)));	// one AVX2 register
+
+	union alignas(64) node {
+		T s[B];
+		vec v[2];
+	};
+
+  private:
+	ull n_;
+	ull H_;					// levels count
+	vector<ull> offset_;	// index of the first node of each level (leaves level is 0)
+	vector<node> data_;
+	vector<node> mask_;		// mask_[i][j] = (j > i ? -1 : 0)
+
+  public:
+	// build segment tree over the empty vector of size _n
+	wideSegtree(ull n): n_(n), H_(1), mask_(B) {
+		for(ull cap = B; cap <= n_; cap *= B) ++H_;
+		offset_.assign(H_ + 1, 0);
+		for(ull h = 0, sz = n_; h < H_; ++h) {
+			sz = sz / B + 1;
+			offset_[h+1] = offset_[h] + sz;
+		}
+		data_.assign(offset_[H_], node{});
+		for(ull i = 0; i < B; ++i) {
+			for(ull j = 0; j < B; ++j) mask_[i].s[j] = (j > i ? T(-1) : T(0));
+		}
+	}
+
+	// builds segment tree over the given vector
+	wideSegtree(const vector<T>& a): wideSegtree(a.size()) {
+		vector<T> sum(a), upper;	// sums of subtrees of the current level
+		for(ull h = 0; h < H_; ++h) {
+			upper.assign(offset_[h+1] - offset_[h], T());
+			for(ull i = 0; i < sum.size(); ++i) {
+				node& t = data_[offset_[h] + i / B];
+				if(i % B + 1 < B) t.s[i % B + 1] = t.s[i % B] + sum[i];
+				upper[i / B] += sum[i];
+			}
+			swap(sum, upper);
+		}
+	}
+
+	// returns the pth element of the vector
+	T get(ull p) { return prefix(p) - prefix(p-1); }
+
+	// computes the sum of the elements of subvector [l; r]
+	T get(ull l, ull r) { return prefix(r) - prefix(l-1); }
+
+	// adds x to pth element of the vector
+	void update(ull p, T x) {
+		for(ull h = 0, k = p-1; h < H_; ++h, k /= B) {
+			node& t = data_[offset_[h] + k / B];
+			const node& m = mask_[k % B];
+			t.v[0] += x & m.v[0];
+			t.v[1] += x & m.v[1];
+		}
+	}
+
+	// computes the sum of the elements of subvector [1; p]
+	T prefix(ull p) {
+		T res = T();
+		for(ull h = 0, k = p; h < H_; ++h, k /= B) {
+			res += data_[offset_[h] + k / B].s[k % B];
+		}
+		return res;
+	}
+};
+
+int main() {
+
+	vector<int> arr = {1, 2, 3, 4, 5, 6, 7, 8};
+
+	wideSegtree<int> seg(arr);
+
+	cout << seg.get(1, 3) << '\n';		// 6
+	cout << seg.get(4, 8) << '\n';		// 30
+	seg.update(2, 5);					// {1, 7, 3, 4, 5, 6, 7, 8}
+	cout << seg.get(2) << '\n';			// 7
+	cout << seg.get(1, 8) << '\n';		// 41
+}